@@ -66,6 +66,7 @@ make all
 %files
 %defattr(-,root,root)
 %{module_path}/*.so
+%{_bindir}/udjat-smart-dump
 %config %{_sysconfdir}/%{product_name}.conf.d/*.conf
 
 %changelog
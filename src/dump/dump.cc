@@ -0,0 +1,360 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief One-shot S.M.A.R.T. dump of every physical disk on the host.
+  *
+  * Reads the disks concurrently and writes one JSON object per line to stdout
+  * as each disk completes, without starting the udjat service.
+  *
+  */
+
+ #include <config.h>
+ #include <udjat/smart/disk.h>
+ #include <udjat/smart/blob.h>
+ #include <iostream>
+ #include <sstream>
+ #include <memory>
+ #include <mutex>
+ #include <condition_variable>
+ #include <thread>
+ #include <chrono>
+ #include <vector>
+ #include <list>
+ #include <getopt.h>
+ #include <unistd.h>
+
+ using namespace std;
+ using namespace Udjat;
+
+//---[ Implement ]------------------------------------------------------------------------------------------
+
+ /// @brief Options.
+ static struct {
+	size_t jobs = 16;
+	unsigned int timeout = 30;
+	bool blob = false;
+ } options;
+
+ /// @brief Disk read, shared with its (possibly abandoned) worker thread.
+ struct Job {
+	vector<string> paths;
+	chrono::steady_clock::time_point deadline;
+	bool done = false;
+	bool failed = false;
+	string json;
+ };
+
+ static mutex guard;
+ static condition_variable finished;
+
+ static string escape(const char *str) {
+
+	string value{"\""};
+
+	for(const char *ptr = str; *ptr; ptr++) {
+		switch(*ptr) {
+		case '"':
+			value += "\\\"";
+			break;
+		case '\\':
+			value += "\\\\";
+			break;
+		default:
+			if(((unsigned char) *ptr) < 0x20) {
+				char buffer[8];
+				snprintf(buffer,sizeof(buffer),"\\u%04x",(unsigned int) *ptr);
+				value += buffer;
+			} else {
+				value += *ptr;
+			}
+		}
+	}
+
+	return value + "\"";
+
+ }
+
+ static string paths(const vector<string> &paths) {
+	string value{"["};
+	for(size_t ix = 0; ix < paths.size(); ix++) {
+		if(ix) {
+			value += ",";
+		}
+		value += escape(paths[ix].c_str());
+	}
+	return value + "]";
+ }
+
+ /// @brief Read disk, build the JSON line.
+ static string dump(const vector<string> &devices, bool &failed) {
+
+	auto started = chrono::steady_clock::now();
+
+	stringstream json;
+
+	json << "{\"device\":" << escape(devices[0].c_str()) << ",\"paths\":" << paths(devices);
+
+	try {
+
+		Smart::Disk disk(devices[0].c_str());
+
+		if(disk.identify_is_available()) {
+			auto ipd = disk.identify();
+			json	<< ",\"model\":" << escape(ipd->model)
+					<< ",\"serial\":" << escape(ipd->serial)
+					<< ",\"firmware\":" << escape(ipd->firmware);
+		}
+
+		try {
+			uint64_t size = disk.size();
+			json << ",\"size\":" << size;
+		} catch(const std::exception &) {
+			// Not available on recorded data.
+		}
+
+		disk.read();
+
+		json << ",\"overall\":" << escape(sk_smart_overall_to_string(disk.getOverral()));
+
+		Temperature temperature = disk.temperature();
+		if(!temperature.empty()) {
+			json << ",\"temperature\":" << temperature.as_celsius();
+		}
+
+		// Optional, SSDs without attributes 5 and 197 have no bad sector count.
+		try {
+			uint64_t badsectors = disk.badsectors();
+			json << ",\"badsectors\":" << badsectors;
+		} catch(const std::exception &) {
+		}
+
+		try {
+			uint64_t poweron = disk.poweron();
+			json << ",\"poweron\":" << poweron;
+		} catch(const std::exception &) {
+		}
+
+		try {
+			uint64_t powercicle = disk.powercicle();
+			json << ",\"powercicle\":" << powercicle;
+		} catch(const std::exception &) {
+		}
+
+		json << ",\"attributes\":[";
+
+		bool first = true;
+		disk.attributes([&json,&first](const SkSmartAttributeParsedData &a) {
+
+			uint64_t raw = 0;
+			for(size_t ix = 0; ix < 6; ix++) {
+				raw |= ((uint64_t) a.raw[ix]) << (ix * 8);
+			}
+
+			json	<< (first ? "" : ",")
+					<< "{\"id\":" << (unsigned int) a.id
+					<< ",\"name\":" << escape(a.name ? a.name : "")
+					<< ",\"prefail\":" << (a.prefailure ? "true" : "false")
+					<< ",\"current\":" << (unsigned int) a.current_value
+					<< ",\"worst\":" << (unsigned int) a.worst_value
+					<< ",\"threshold\":" << (unsigned int) a.threshold
+					<< ",\"raw\":" << raw
+					<< "}";
+
+			first = false;
+
+		});
+
+		json << "]";
+
+		if(options.blob) {
+			json << ",\"blob\":" << escape(disk.blob().encoded().c_str());
+		}
+
+	} catch(const std::exception &e) {
+
+		json << ",\"error\":" << escape(e.what());
+		failed = true;
+
+	}
+
+	json << ",\"elapsed\":" << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - started).count() << "}";
+
+	return json.str();
+
+ }
+
+ static void usage(const char *argv0) {
+	cerr	<< "Usage: " << argv0 << " [options] [device...]" << endl << endl
+			<< "  -j, --jobs=N       Disks read at the same time (default " << options.jobs << ")" << endl
+			<< "  -t, --timeout=S    Give up on a disk after S seconds, 0 to wait forever (default " << options.timeout << ")" << endl
+			<< "  -b, --blob         Add the raw S.M.A.R.T. data (base64) for later replay" << endl
+			<< "  -h, --help         Show this help" << endl;
+ }
+
+int main(int argc, char **argv) {
+
+	static const struct option longopts[] = {
+		{ "jobs",		required_argument,	0, 'j' },
+		{ "timeout",	required_argument,	0, 't' },
+		{ "blob",		no_argument,		0, 'b' },
+		{ "help",		no_argument,		0, 'h' },
+		{ 0, 0, 0, 0 }
+	};
+
+	int opt;
+	while((opt = getopt_long(argc, argv, "j:t:bh", longopts, NULL)) != -1) {
+		switch(opt) {
+		case 'j':
+			options.jobs = (size_t) atoi(optarg);
+			if(!options.jobs) {
+				options.jobs = 1;
+			}
+			break;
+
+		case 't':
+			if(atoi(optarg) < 0) {
+				usage(argv[0]);
+				return -1;
+			}
+			options.timeout = (unsigned int) atoi(optarg);
+			break;
+
+		case 'b':
+			options.blob = true;
+			break;
+
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+
+	list<shared_ptr<Job>> pending;
+
+	if(optind < argc) {
+		for(int ix = optind; ix < argc; ix++) {
+			auto job = make_shared<Job>();
+			job->paths.push_back(argv[ix]);
+			pending.push_back(job);
+		}
+	} else {
+		for(auto &devices : Smart::Disk::enumerate()) {
+			auto job = make_shared<Job>();
+			job->paths = devices;
+			pending.push_back(job);
+		}
+	}
+
+	list<shared_ptr<Job>> active;
+	size_t failed = 0, abandoned = 0;
+
+	unique_lock<mutex> lock(guard);
+
+	while(!(pending.empty() && active.empty())) {
+
+		// Start workers up to the pool size.
+		while(!pending.empty() && active.size() < options.jobs) {
+
+			auto job = pending.front();
+			pending.pop_front();
+
+			if(options.timeout) {
+				job->deadline = chrono::steady_clock::now() + chrono::seconds(options.timeout);
+			} else {
+				// No timeout, wait for the worker.
+				job->deadline = chrono::steady_clock::time_point::max();
+			}
+			active.push_back(job);
+
+			thread([job](){
+				bool failed = false;
+				string json = dump(job->paths,failed);
+				lock_guard<mutex> lock(guard);
+				job->json = json;
+				job->failed = failed;
+				job->done = true;
+				finished.notify_all();
+			}).detach();
+
+		}
+
+		// Wait for the first completion or deadline.
+		auto deadline = active.front()->deadline;
+		for(auto &job : active) {
+			if(job->deadline < deadline) {
+				deadline = job->deadline;
+			}
+		}
+
+		auto completed = [&active]{
+			for(auto &job : active) {
+				if(job->done) {
+					return true;
+				}
+			}
+			return false;
+		};
+
+		if(deadline == chrono::steady_clock::time_point::max()) {
+			finished.wait(lock,completed);
+		} else {
+			finished.wait_until(lock,deadline,completed);
+		}
+
+		auto now = chrono::steady_clock::now();
+
+		for(auto job = active.begin(); job != active.end();) {
+
+			if((*job)->done) {
+
+				cout << (*job)->json << endl;
+				if((*job)->failed) {
+					failed++;
+				}
+				job = active.erase(job);
+
+			} else if(now >= (*job)->deadline) {
+
+				// The worker can't be cancelled (blocked on an ioctl), abandon it.
+				cout << "{\"device\":" << escape((*job)->paths[0].c_str()) << ",\"paths\":" << paths((*job)->paths) << ",\"error\":\"Timeout\"}" << endl;
+				failed++;
+				abandoned++;
+				job = active.erase(job);
+
+			} else {
+
+				job++;
+
+			}
+
+		}
+
+	}
+
+	cout.flush();
+
+	if(abandoned) {
+		// Don't wait for (or destroy objects used by) the abandoned workers.
+		_exit(2);
+	}
+
+	return failed ? 1 : 0;
+
+}
@@ -22,43 +22,301 @@
  #include <udjat/defs.h>
  #include <udjat/agent.h>
  #include <udjat/tools/disk/stat.h>
+ #include <udjat/smart/trend.h>
+ #include <udjat/smart/attributes.h>
+ #include <udjat/smart/load.h>
+ #include <udjat/smart/thermal.h>
+ #include <udjat/smart/blob.h>
+ #include <udjat/smart/endurance.h>
+ #include <atomic>
+ #include <vector>
+ #include <string>
+ #include <mutex>
+ #include <memory>
 
  namespace Udjat {
 
 	namespace Smart {
 
+		class Disk;
+		class Controller;
+		class Array;
+		class CBOR;
+
+		/// @brief Agent values beyond SkSmartOverall.
+		enum AgentValue : unsigned short {
+			PREDICTED_FAILURE = 0x0100,		///< @brief Failure trend reaches threshold inside the warning window.
+			ATTRIBUTE_WARNING = 0x0101,		///< @brief At least one attribute reached its warning level.
+			ATTRIBUTE_ERROR = 0x0102,		///< @brief At least one attribute reached its error level.
+			ARRAY_RISK = 0x0103,			///< @brief Warning on a member of a degraded RAID array.
+			ENDURANCE_WARNING = 0x0104,		///< @brief SSD projected life below the warning limit.
+			CONTROLLER_FAILURE = 0x0105,	///< @brief Failure folded into a correlated host adapter failure.
+		};
+
+		/// @brief Response fields for Agent::get(), selected with '?fields=name,name...'.
+		enum Field : uint16_t {
+			FIELD_STATE			= 0x0001,	///< @brief Agent state only (always exported).
+			FIELD_TEMPERATURE	= 0x0002,
+			FIELD_SIZE			= 0x0004,
+			FIELD_IDENTIFY		= 0x0008,	///< @brief Serial, firmware and model.
+			FIELD_BADSECTORS	= 0x0010,
+			FIELD_POWERON		= 0x0020,
+			FIELD_POWERCICLE	= 0x0040,
+			FIELD_IOSTATS		= 0x0080,	///< @brief Read and write rates (diskstats).
+			FIELD_ATTRIBUTE		= 0x0100,	///< @brief Worst evaluated attribute.
+			FIELD_FORECAST		= 0x0200,	///< @brief Failure trend forecast.
+			FIELD_DEFERRED		= 0x0400,	///< @brief Deferred poll counter.
+			FIELD_THERMAL		= 0x0800,	///< @brief Temperature min/max/avg windows.
+			FIELD_PATHS			= 0x1000,	///< @brief Active device and all paths.
+			FIELD_MEMORY		= 0x2000,	///< @brief Memory accounting.
+			FIELD_BLOB			= 0x4000,	///< @brief Raw S.M.A.R.T. data (only on explicit request).
+			FIELD_ENDURANCE		= 0x8000,	///< @brief SSD writes, write amplification and projected life.
+			FIELD_ALL			= 0xFFFF,
+
+			/// @brief Fields requiring a S.M.A.R.T. read.
+			FIELD_DISK_DATA		= FIELD_TEMPERATURE|FIELD_BADSECTORS|FIELD_POWERON|FIELD_POWERCICLE
+		};
+
+		/// @brief Get the selected fields from the request.
+		/// @return Bitmask of the requested fields (FIELD_ALL if the request has no field selector).
+		UDJAT_API uint16_t fields(const Udjat::Request &request);
+
 		/// @brief S.M.A.R.T. agent.
 		class UDJAT_API Agent : public Udjat::Agent<unsigned short> {
 		private:
-			const char *devicename;
+
+			/// @brief Active device path, changed by failover() while other threads read it.
+			std::atomic<const char *> devicename;
+
+			/// @brief All paths to the physical device (multipath), the active one included.
+			std::vector<const char *> paths;
+
+			/// @brief Last known bad sector count.
+			uint64_t badsectors = 0;
+
+			/// @brief Is the agent on failed state?
+			bool failing = false;
+
+			/// @brief Record samples on the history store?
+			bool history = true;
+
+			/// @brief Compact mode (shared predefined states, pooled strings).
+			bool compact = false;
+
+			/// @brief Number of started parents; a reused agent is started by the new
+			/// configuration before the old one is stopped.
+			std::atomic<unsigned int> running{0};
+
+			/// @brief Cache the values from the last full read, record a history sample.
+			void record(Smart::Disk &disk) noexcept;
+
+			/// @brief Values from the last full read.
+			struct {
+				time_t timestamp = 0;
+				uint64_t temperature = 0;	///< @brief mKelvin (0 if not available).
+				uint64_t poweron = 0;		///< @brief mseconds.
+				uint64_t powercicle = 0;
+			} snapshot;
+
+			/// @brief Raw S.M.A.R.T. data from the last full reads.
+			struct {
+
+				std::mutex guard;
+
+				/// @brief Distinct blobs to keep (0 disables the capture).
+				size_t limit = 1;
+
+				struct Capture {
+					std::shared_ptr<Blob> blob;
+					uint64_t signature = 0;		///< @brief Hash of the failure relevant data.
+					bool pinned = false;		///< @brief First capture on a new agent state, kept over the others.
+				};
+
+				/// @brief The captured blobs, oldest first.
+				std::vector<Capture> values;
+
+				/// @brief Agent value on the last capture.
+				unsigned short captured = 0;
+
+			} blobs;
+
+			/// @brief The host adapter, for correlated failure detection (nullptr if not grouped).
+			std::shared_ptr<Controller> controller;
+
+			/// @brief Agents aggregating this one (topology groups, RAID arrays), refreshed after it.
+			std::vector<std::weak_ptr<Abstract::Agent>> aggregations;
+
+			/// @brief Fold the disk failure into the host adapter state.
+			void fold();
+
+			/// @brief RAID membership (md or dm-raid).
+			struct {
+
+				/// @brief The array (nullptr if not a member).
+				std::shared_ptr<Array> array;
+
+				/// @brief Refreshes per full read while the array is healthy.
+				unsigned int interval = 4;
+
+				/// @brief Is the array degraded or rebuilding?
+				bool degraded = false;
+
+			} raid;
+
+			/// @brief Check the RAID array, get polling priority from its status.
+			/// @return true if the S.M.A.R.T. read should be skipped (resync in progress).
+			bool resync() noexcept;
+
+			/// @brief Capture the raw data from the last full read.
+			void capture(Smart::Disk &disk) noexcept;
+
+			/// @brief Switch to the next device path.
+			/// @return false if there's no other path.
+			bool failover() noexcept;
+
+			/// @brief Poll the active path, update the state.
+			void poll();
+
+			/// @brief Device information cached on init (doesn't change while running).
+			struct {
+				std::string size;
+				std::string serial;
+				std::string firmware;
+				std::string model;
+				uint64_t bytes = 0;
+			} info;
 
 			/// @brief Initialize
 			void init();
 
 			/// @brief I/O unit (nullptr if disabled).
-			const Disk::Unit *unit = nullptr;
+			const Udjat::Disk::Unit *unit = nullptr;
 
 			/// @brief I/O statistics.
-			Disk::Stat::Data stats;
+			Udjat::Disk::Stat::Data stats;
+
+			/// @brief Failure trend predictor.
+			struct {
+
+				/// @brief Pending and reallocated sectors.
+				Trend badsectors;
+
+				/// @brief Lowest margin between pre-fail attributes and their thresholds.
+				Trend prefail{false};
+
+				/// @brief Bad sector count considered as failure.
+				unsigned int limit = 50;
+
+				/// @brief Warning window in seconds (0 disables the predicted failure state).
+				time_t window = 0;
+
+			} trend;
+
+			/// @brief Per attribute evaluator.
+			AttributeEvaluator evaluator;
+
+			/// @brief Last attribute evaluation.
+			AttributeEvaluator::Result attribute;
+
+			/// @brief Load-aware polling, defers S.M.A.R.T. reads while the disk is busy.
+			struct {
+
+				/// @brief Utilization threshold in percent (0 to disable).
+				unsigned int utilization = 0;
+
+				/// @brief Average in-flight requests threshold (0 to disable).
+				unsigned int inflight = 0;
+
+				/// @brief Maximum time without a S.M.A.R.T. read (seconds).
+				time_t max = 600;
+
+				/// @brief Time of the last S.M.A.R.T. read.
+				time_t last = 0;
+
+				/// @brief Number of deferred polls.
+				uint64_t count = 0;
+
+				/// @brief The load sampler (nullptr if disabled).
+				std::shared_ptr<Load> load;
+
+			} deferral;
+
+			/// @brief Tiered polling, cheap status query between full reads.
+			struct {
+
+				/// @brief Refreshes per full read (0 or 1 to always do a full read).
+				unsigned int interval = 0;
+
+				/// @brief Fast tier refreshes left until the next full read.
+				unsigned int countdown = 0;
+
+			} tier;
+
+			/// @brief SSD endurance.
+			struct {
+
+				/// @brief The tracker (nullptr if disabled).
+				std::shared_ptr<Endurance> tracker;
+
+				/// @brief Projected life (seconds) considered as warning (0 disables the state).
+				time_t warning = 0;
+
+			} endurance;
+
+			/// @brief High frequency temperature sampler (nullptr if disabled).
+			std::shared_ptr<Thermal> thermal;
+
+			/// @brief Check if the S.M.A.R.T. read should be deferred.
+			bool defer() noexcept;
+
+			/// @brief Evaluate attributes, update the failure trend, get the agent value.
+			unsigned short evaluate(Smart::Disk &disk, unsigned short overall);
 
 		public:
 
 			Agent(const char *name);
 			Agent(const pugi::xml_node &node);
 			Agent(const char *name, const pugi::xml_node &node);
+
+			/// @brief Create agent for a physical device with more than one path.
+			/// @param paths The device paths, the first one is polled until it fails.
+			Agent(const std::vector<std::string> &paths, const pugi::xml_node &node);
+
 			virtual ~Agent();
 
 			/// @brief Get device name.
 			inline const char * getDeviceName() const noexcept {
-				return this->devicename;
+				return this->devicename.load();
+			}
+
+			/// @brief Attach agent to its host adapter.
+			inline void attach(const std::shared_ptr<Controller> &controller) noexcept {
+				this->controller = controller;
+			}
+
+			/// @brief Attach agent to its RAID array.
+			inline void attach(const std::shared_ptr<Array> &array) noexcept {
+				this->raid.array = array;
 			}
 
+			/// @brief Attach agent to an aggregation (topology group or RAID array agent).
+			void attach(const std::shared_ptr<Abstract::Agent> &aggregation);
+
+			/// @brief Start the agent, if not already started by another configuration.
+			void start() override;
+
+			/// @brief Stop the agent when the last configuration using it is stopped.
+			void stop() override;
+
 			/// @brief Get device status, update internal state.
 			bool refresh() override;
 
 			/// @brief Export device info.
 			void get(const Udjat::Request &request, Udjat::Response &response) override;
 
+			/// @brief Encode the cached device info as a CBOR disk record (doesn't touch the disk).
+			void encode(CBOR &cbor);
+
 			std::shared_ptr<Abstract::State> computeState() override;
 
 		};
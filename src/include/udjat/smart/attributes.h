@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <pugixml.hpp>
+ #include <atasmart.h>
+ #include <array>
+ #include <vector>
+ #include <cstdint>
+
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief Well-known ATA attribute definition.
+		struct AttributeDefinition {
+
+			/// @brief Which value gets worse?
+			enum Direction : uint8_t {
+				None,			///< @brief Informational only, never evaluated.
+				Higher,			///< @brief Higher pretty (raw) value is worse.
+				Lower			///< @brief Lower normalized value is worse.
+			};
+
+			uint8_t id;
+			const char *name;
+			bool prefail;
+			Direction direction;
+			uint64_t warning;		///< @brief Warning level (0 to disable).
+			uint64_t error;			///< @brief Error level (0 to disable).
+			SkSmartAttributeUnit unit;
+
+			/// @brief Get definition for attribute id.
+			/// @return The definition or nullptr if the attribute is unknown.
+			static const AttributeDefinition * find(uint8_t id) noexcept;
+
+		};
+
+		/// @brief Per-agent attribute evaluator.
+		class UDJAT_API AttributeEvaluator {
+		public:
+
+			/// @brief Evaluation result.
+			struct Result {
+				Udjat::Level level = Udjat::ready;
+				uint8_t id = 0;		///< @brief The worst attribute id (0 if all attributes are ok).
+				uint64_t value = 0;	///< @brief The worst attribute value.
+			};
+
+		private:
+
+			/// @brief Per attribute overrides from XML.
+			struct Override {
+				uint8_t id;
+				AttributeDefinition::Direction direction;
+				uint64_t warning;
+				uint64_t error;
+			};
+
+			std::vector<Override> overrides;
+
+		public:
+
+			AttributeEvaluator() = default;
+
+			/// @brief Get the memory used by the overrides.
+			inline size_t size() const noexcept {
+				return overrides.capacity() * sizeof(Override);
+			}
+
+			/// @brief Load overrides from <smart-attribute id='' warning='' error='' direction='' /> children.
+			void load(const pugi::xml_node &node);
+
+			/// @brief Evaluate one attribute.
+			/// @param a The parsed attribute.
+			/// @param value The evaluated value (pretty or normalized, depending on the direction).
+			Udjat::Level evaluate(const SkSmartAttributeParsedData &a, uint64_t &value) const noexcept;
+
+			/// @brief Evaluate attribute, keep the worst one.
+			void evaluate(const SkSmartAttributeParsedData &a, Result &result) const noexcept;
+
+		};
+
+	}
+
+ }
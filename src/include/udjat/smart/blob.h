@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <string>
+ #include <ctime>
+
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief Raw S.M.A.R.T. data (libatasmart blob or NVMe log page).
+		class UDJAT_API Blob {
+		private:
+
+			/// @brief Raw data.
+			std::string data;
+
+			/// @brief Capture time.
+			time_t timestamp = 0;
+
+			/// @brief Cached base64 encoding.
+			mutable std::string base64;
+
+		public:
+			Blob() = default;
+
+			Blob(std::string &&raw, time_t t = ::time(nullptr)) : data{std::move(raw)}, timestamp{t} {
+			}
+
+			inline bool empty() const noexcept {
+				return data.empty();
+			}
+
+			inline const std::string & raw() const noexcept {
+				return data;
+			}
+
+			inline time_t captured() const noexcept {
+				return timestamp;
+			}
+
+			inline bool operator==(const Blob &blob) const noexcept {
+				return data == blob.data;
+			}
+
+			inline bool operator!=(const Blob &blob) const noexcept {
+				return data != blob.data;
+			}
+
+			/// @brief Get the base64 encoded data (encoded only once).
+			const std::string & encoded() const;
+
+		};
+
+	}
+
+ }
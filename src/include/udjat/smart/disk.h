@@ -21,7 +21,11 @@
 
  #include <udjat/defs.h>
  #include <udjat/tools/temperature.h>
+ #include <udjat/smart/blob.h>
  #include <string>
+ #include <memory>
+ #include <type_traits>
+ #include <vector>
  #include <atasmart.h>
 
  namespace Udjat {
@@ -30,14 +34,71 @@
 
 		/// @brief S.M.A.R.T. disk abstraction.
 		class UDJAT_API Disk {
+		public:
+
+			/// @brief I/O priority on the module rate limiter.
+			enum Priority : uint8_t {
+				Refresh,		///< @brief State refresh, has priority.
+				Request			///< @brief On-demand read, only uses the spare rate.
+			};
+
+			/// @brief Device backend (libatasmart, NVMe, ...).
+			class UDJAT_API Backend {
+			public:
+				virtual ~Backend();
+
+				/// @brief True if status() already read the health data, the next read() can skip it.
+				bool fresh = false;
+
+				/// @brief Read (or re-read) device health data.
+				virtual void read() = 0;
+
+				/// @brief Cheap pass/fail health query (reads the health data by default).
+				/// @return true if the device reports a good health status.
+				virtual bool status();
+
+				virtual bool identify_is_available() = 0;
+				virtual const SkIdentifyParsedData * identify() = 0;
+				virtual SkSmartOverall overall() = 0;
+				virtual bool is_awake() = 0;
+				virtual uint64_t size() = 0;
+				virtual uint64_t badsectors() = 0;
+
+				/// @brief Get power on time in milliseconds.
+				virtual uint64_t poweron() = 0;
+
+				virtual uint64_t powercicle() = 0;
+
+				/// @brief Get temperature in mKelvin (0 if not available).
+				virtual uint64_t temperature() = 0;
+
+				/// @brief Get the raw device data for offline analysis or replay.
+				virtual std::string blob();
+
+				/// @brief Attribute callback, the same convention as sk_disk_smart_parse_attributes.
+				typedef void (*Callback)(const SkSmartAttributeParsedData &attribute, void *userdata);
+
+				/// @brief Enumerate parsed attributes (none by default).
+				virtual void attributes(Callback call, void *userdata);
+
+			};
+
 		private:
-			SkDisk *d;
+			std::unique_ptr<Backend> backend;
+
+			Priority priority;
 
 		public:
-			Disk(const char *name);
+			/// @brief Open disk.
+			/// @param name The device name or a recorded file (NVMe log page or libatasmart blob).
+			Disk(const char *name, Priority priority = Refresh);
 			~Disk();
 
 			Disk & read();
+
+			/// @brief Get the device self assessment without a full S.M.A.R.T. read.
+			/// @return true if the device reports a good health status.
+			bool status();
 			const SkIdentifyParsedData * identify();
 			SkSmartOverall getOverral();
 
@@ -50,7 +111,7 @@
 			/// @brief get the power cycle count.
 			uint64_t powercicle();
 
-			/// @brief get the number of bad sectors (i.e. pending and reallocated).
+			/// @brief get the disk temperature.
 			Udjat::Temperature temperature();
 
 			/// @brief Is the disk awake?
@@ -61,6 +122,33 @@
 
 			std::string formattedSize();
 
+			/// @brief Get the raw S.M.A.R.T. data from the last read.
+			/// The blob can be replayed using its file name as device name.
+			Blob blob();
+
+			/// @brief Overall status values considered healthy.
+			static inline bool good(SkSmartOverall overall) noexcept {
+				return overall == SK_SMART_OVERALL_GOOD || overall == SK_SMART_OVERALL_BAD_ATTRIBUTE_IN_THE_PAST;
+			}
+
+			/// @brief Enumerate the physical disks.
+			/// @param multipath Group the paths to the same device (by WWN).
+			/// @return The device paths of each physical disk.
+			static std::vector<std::vector<std::string>> enumerate(bool multipath = true);
+
+			/// @brief Enumerate parsed attributes.
+			/// @param call Callable with a 'const SkSmartAttributeParsedData &' argument, called
+			/// without type erasure (no heap allocation for large captures).
+			template <typename T>
+			inline void attributes(T &&call) {
+				backend->attributes(
+					[](const SkSmartAttributeParsedData &attribute, void *userdata) {
+						(*((typename std::remove_reference<T>::type *) userdata))(attribute);
+					},
+					(void *) &call
+				);
+			}
+
 		};
 
 	}
@@ -0,0 +1,136 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <mutex>
+ #include <string>
+ #include <cstdint>
+ #include <ctime>
+
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief SSD endurance tracker, host writes (diskstats) against NAND writes and wear
+		/// attributes, with write amplification and projected life over sliding windows.
+		class UDJAT_API Endurance {
+		public:
+
+			/// @brief Maximum number of windows.
+			static constexpr size_t MAX_WINDOWS = 4;
+
+			/// @brief Buckets per window.
+			static constexpr size_t BUCKETS = 32;
+
+			/// @brief Cumulative counters.
+			struct Sample {
+				time_t timestamp = 0;
+				uint64_t host = 0;		///< @brief Host writes since the tracker started (bytes).
+				uint64_t nand = 0;		///< @brief NAND writes reported by the device (bytes, 0 if not available).
+				float life = -1;		///< @brief Life left in percent (negative if not available).
+				uint64_t poweron = 0;	///< @brief Power on time (seconds).
+			};
+
+			/// @brief Rates over a window.
+			struct Value {
+				time_t seconds = 0;		///< @brief Time covered by the samples.
+				double write = 0;		///< @brief Host writes (bytes per second).
+				float waf = 0;			///< @brief Write amplification (0 if not available).
+				float wear = 0;			///< @brief Life used (percent per day).
+				uint64_t remaining = 0;	///< @brief Projected life left (seconds, 0 if worn out).
+				bool projected = false;	///< @brief Is there an estimate? (remaining is meaningless if false).
+			};
+
+			/// @brief Sliding window, keeps the first sample of each bucket.
+			class UDJAT_API Window {
+			private:
+
+				/// @brief Window length in seconds (0 if not in use).
+				time_t seconds = 0;
+
+				Sample buckets[BUCKETS];
+
+			public:
+
+				inline time_t length() const noexcept {
+					return seconds;
+				}
+
+				void reset(time_t seconds) noexcept;
+				void push_back(const Sample &sample) noexcept;
+
+				/// @brief Get rates from the oldest sample in the window to the current one.
+				Value get(const Sample &current) const noexcept;
+
+			};
+
+		private:
+
+			mutable std::mutex guard;
+
+			/// @brief sysfs stat file.
+			std::string filename;
+
+			/// @brief Bytes per NAND write attribute unit.
+			uint64_t unit;
+
+			/// @brief Last kernel written sectors counter.
+			uint64_t sectors = 0;
+
+			Sample current;
+
+			Window windows[MAX_WINDOWS];
+
+		public:
+
+			/// @param devicename The device name (/dev/sda).
+			/// @param windows Comma separated window lengths in seconds.
+			/// @param unit Bytes per NAND write attribute unit.
+			Endurance(const char *devicename, const char *windows, uint64_t unit);
+
+			/// @brief Move the host write counter to another path of the same device (multipath failover).
+			/// @param devicename The new device name.
+			void rebind(const char *devicename);
+
+			/// @brief Update from a full S.M.A.R.T. read.
+			/// @param timestamp The read time.
+			/// @param nand NAND writes attribute raw value (0 if not available).
+			/// @param life Life left in percent (negative if not available).
+			/// @param poweron Power on time in seconds.
+			void push_back(time_t timestamp, uint64_t nand, float life, uint64_t poweron) noexcept;
+
+			/// @brief Get the last sample.
+			Sample get() const noexcept;
+
+			/// @brief Get rates for window.
+			/// @return false if the window is not in use.
+			bool get(size_t window, Value &value) const noexcept;
+
+			/// @brief Projected life left, from the first window with an estimate or, if none, from the power on time.
+			/// @param seconds The projected life left (0 if the life attribute is exhausted).
+			/// @return false if unknown.
+			bool remaining(uint64_t &seconds) const noexcept;
+
+		};
+
+	}
+
+ }
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <cstdint>
+ #include <string>
+
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief Block device load sampler (from /sys/block/[name]/stat).
+		class UDJAT_API Load {
+		private:
+
+			/// @brief sysfs stat file.
+			std::string filename;
+
+			/// @brief Previous sample.
+			struct {
+				uint64_t timestamp = 0;		///< @brief Monotonic time in ms.
+				uint64_t ticks = 0;			///< @brief Time spent doing I/O (ms).
+				uint64_t queue = 0;			///< @brief Weighted time spent doing I/O (ms).
+				uint64_t ios = 0;			///< @brief Completed reads and writes.
+				uint64_t wait = 0;			///< @brief Time spent on reads and writes (ms).
+			} last;
+
+		public:
+
+			/// @brief Load over the last interval.
+			struct Value {
+				float utilization = 0;		///< @brief Percent of time the device was busy.
+				float inflight = 0;			///< @brief Average requests in flight.
+				float latency = 0;			///< @brief Average time per completed request (ms).
+			};
+
+			/// @brief Create sampler.
+			/// @param devicename The device name (/dev/sda).
+			Load(const char *devicename);
+
+			/// @brief Move the sampler to another path of the same device (multipath failover).
+			/// @param devicename The new device name.
+			void rebind(const char *devicename);
+
+			/// @brief Sample the device, get the load since the last sample.
+			/// @return The load (zero on the first sample or if the device has no statistics).
+			Value sample() noexcept;
+
+		};
+
+	}
+
+ }
@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <udjat/tools/temperature.h>
+ #include <mutex>
+ #include <string>
+ #include <cstdint>
+ #include <ctime>
+
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief Lightweight temperature sampler, independent of the S.M.A.R.T. reads.
+		/// Uses the kernel hwmon sensor when available, SCT status on ATA devices or the
+		/// NVMe health log page; runs on a module thread at its own interval.
+		class UDJAT_API Thermal {
+		public:
+
+			/// @brief Maximum number of aggregation windows.
+			static constexpr size_t MAX_WINDOWS = 4;
+
+			/// @brief Buckets per window.
+			static constexpr size_t BUCKETS = 30;
+
+			/// @brief Min/max/avg over a time window, in constant memory.
+			class UDJAT_API Window {
+			private:
+
+				/// @brief Window length in seconds (0 if not in use).
+				time_t seconds = 0;
+
+				struct Bucket {
+					time_t slot = 0;		///< @brief Bucket time slot (timestamp / width).
+					float min = 0;
+					float max = 0;
+					float sum = 0;
+					unsigned int count = 0;
+				} buckets[BUCKETS];
+
+			public:
+
+				/// @brief Aggregated values, in Celsius.
+				struct Value {
+					float min = 0;
+					float max = 0;
+					float avg = 0;
+					unsigned int count = 0;
+				};
+
+				inline time_t length() const noexcept {
+					return seconds;
+				}
+
+				void reset(time_t seconds) noexcept;
+				void push_back(float celsius, time_t timestamp) noexcept;
+				Value get(time_t timestamp) const noexcept;
+
+			};
+
+		private:
+
+			/// @brief New device path, picked up by the sampler thread on the next sample.
+			std::string rebound;
+
+			/// @brief Sensor type.
+			enum Source : uint8_t {
+				None,		///< @brief Not detected yet.
+				HWMon,		///< @brief Kernel hwmon (drivetemp, nvme).
+				SCT,		///< @brief ATA SCT status (SMART READ LOG E0h).
+				NVMe,		///< @brief NVMe SMART/Health log page.
+				Unavailable
+			} source = None;
+
+			std::string devicename;
+
+			/// @brief hwmon temp1_input path.
+			std::string sensor;
+
+			/// @brief Sample interval in seconds.
+			time_t interval;
+
+			/// @brief Next sample time.
+			time_t next = 0;
+
+			mutable std::mutex guard;
+
+			/// @brief Last sample in Celsius.
+			float current = 0;
+
+			/// @brief True if the last sample is valid.
+			bool available = false;
+
+			Window windows[MAX_WINDOWS];
+
+			void detect();
+
+			/// @brief Read sensor.
+			/// @param celsius The temperature in Celsius.
+			/// @return false if not available.
+			bool read(float &celsius);
+
+		public:
+
+			/// @brief Create sampler.
+			/// @param devicename The device name.
+			/// @param interval Sample interval in seconds.
+			/// @param windows Comma separated aggregation window lengths in seconds.
+			Thermal(const char *devicename, time_t interval, const char *windows);
+			~Thermal();
+
+			/// @brief Move the sampler to another path of the same device (multipath failover).
+			/// @param devicename The new device name.
+			void rebind(const char *devicename);
+
+			/// @brief Sample the device if the interval has elapsed.
+			void sample(time_t timestamp) noexcept;
+
+			/// @brief Get the last sample.
+			/// @return false if there's no valid sample.
+			bool get(Udjat::Temperature &temperature) const noexcept;
+
+			/// @brief Get aggregated values for window.
+			/// @return false if the window is not in use.
+			bool get(size_t window, time_t &seconds, Window::Value &value) const noexcept;
+
+		};
+
+	}
+
+ }
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <cstdint>
+ #include <ctime>
+
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief Incremental failure trend estimator.
+		/// Weighted linear regression with exponential forgetting; constant memory, O(1) per sample.
+		class UDJAT_API Trend {
+		private:
+
+			/// @brief Forgetting factor (1 keeps all samples with the same weight).
+			double lambda;
+
+			/// @brief True if the limit is a ceiling (failure when the value rises above it), false for a floor.
+			bool rising;
+
+			/// @brief Timestamp of the first sample, keeps the sums small.
+			time_t origin = 0;
+
+			/// @brief Weighted sums.
+			struct {
+				double w = 0;
+				double x = 0;
+				double y = 0;
+				double xx = 0;
+				double xy = 0;
+			} sum;
+
+			/// @brief Number of samples.
+			size_t samples = 0;
+
+			/// @brief Last sample.
+			double last = 0;
+
+		public:
+			Trend(bool rising = true, double lambda = 0.99) : lambda{lambda}, rising{rising} {
+			}
+
+			/// @brief Add sample.
+			/// @param value The sample value.
+			/// @param timestamp The sample time.
+			void push_back(double value, time_t timestamp = time(nullptr));
+
+			/// @brief Get the regression slope (units per second).
+			double slope() const noexcept;
+
+			/// @brief Predict time to threshold.
+			/// @param limit The threshold value.
+			/// @param timestamp The reference time.
+			/// @return Seconds until the value reaches limit, 1 if already crossed, 0 if not predictable (no samples or stable/improving trend).
+			uint64_t predict(double limit, time_t timestamp = time(nullptr)) const noexcept;
+
+		};
+
+	}
+
+ }
@@ -53,6 +53,20 @@
 
 		std::string to_string() const;
 
+		/// @brief Format temperature without allocating.
+		/// @param buffer The output buffer.
+		/// @param length The buffer length.
+		/// @return buffer (empty string if the temperature is not available).
+		const char * to_string(char *buffer, size_t length) const noexcept;
+
+		inline Unity unit() const noexcept {
+			return unity;
+		}
+
+		inline bool empty() const noexcept {
+			return value == 0;
+		}
+
 		float as_celsius() const;
 		float as_kelvin() const;
 		float as_fahrenheit() const;
@@ -63,12 +63,52 @@
 
 	Smart::Agent::Agent(const char *n, const pugi::xml_node &node) : Udjat::Agent<unsigned short>(getAgentName(n), -1), devicename(Quark(n).c_str()) {
 
+		compact = Attribute(node,"compact",true).as_bool(false);
+
 		init();
 
+		trend.limit = Attribute(node,"trend-bad-sectors",true).as_uint(trend.limit);
+		trend.window = ((time_t) Attribute(node,"trend-warning",true).as_uint(0)) * 3600;
+
+		evaluator.load(node);
+
+		history = Attribute(node,"history",true).as_bool(true);
+
+		blobs.limit = Attribute(node,"blob-history",true).as_uint((unsigned int) blobs.limit);
+
+		raid.interval = Attribute(node,"raid-full-refresh",true).as_uint(raid.interval);
+
+		// Endurance tracking, enabled by default on solid state devices.
+		if(Attribute(node,"endurance",true).as_bool(!Device{getDeviceName()}.rotational)) {
+			endurance.tracker = make_shared<Endurance>(
+										getDeviceName(),
+										Attribute(node,"endurance-windows",true).as_string("86400,2592000"),
+										strtoull(Attribute(node,"nand-write-unit",true).as_string("1073741824"),nullptr,10)
+									);
+			endurance.warning = ((time_t) Attribute(node,"endurance-warning",true).as_uint(0)) * 86400;
+		}
+
+		tier.interval = Attribute(node,"full-refresh",true).as_uint(0);
+
+		{
+			unsigned int interval = Attribute(node,"thermal-interval",true).as_uint(0);
+			if(interval) {
+				thermal = make_shared<Thermal>(getDeviceName(),(time_t) interval,Attribute(node,"thermal-windows",true).as_string("60,3600"));
+			}
+		}
+
+		deferral.utilization = Attribute(node,"defer-utilization",true).as_uint(0);
+		deferral.inflight = Attribute(node,"defer-inflight",true).as_uint(0);
+		deferral.max = (time_t) Attribute(node,"max-deferral",true).as_uint((unsigned int) deferral.max);
+
+		if(deferral.utilization || deferral.inflight) {
+			deferral.load = make_shared<Load>(getDeviceName());
+		}
+
 		if(Attribute(node,"diskstats",true).as_bool(false)) {
 
 			unit = Udjat::Disk::Unit::get(node);
-			Udjat::Disk::Stat(devicename).reset(stats);
+			Udjat::Disk::Stat(getDeviceName()).reset(stats);
 
 		}
 
@@ -78,6 +118,30 @@
 		: Agent(node.attribute("device-name").as_string(),node) {
 	}
 
+	Smart::Agent::Agent(const std::vector<std::string> &p, const pugi::xml_node &node)
+		: Agent(p.at(0).c_str(),node) {
+
+		for(size_t ix = 1; ix < p.size(); ix++) {
+			paths.push_back(Quark(p[ix]).c_str());
+		}
+
+	}
+
+	/// @brief Remove the device name from a predefined state text.
+	static string anonymous(const char *text) {
+
+		string str{text};
+
+		for(const char *token : { " on ${name}", "${name} " }) {
+			size_t pos;
+			while((pos = str.find(token)) != string::npos) {
+				str.erase(pos,strlen(token));
+			}
+		}
+
+		return str;
+	}
+
 	std::shared_ptr<Abstract::State> Smart::Agent::computeState() {
 
 		unsigned short value = super::get();
@@ -139,6 +203,48 @@
 				N_( "Smart Self Assessment negative on ${name}" ),
 				""
 			},
+			{
+				Smart::ATTRIBUTE_WARNING,
+				"attrwarning",
+				Udjat::warning,
+				N_( "Attribute warning on ${name}" ),
+				N_( "At least one attribute reached its warning level on ${name}" )
+			},
+			{
+				Smart::ATTRIBUTE_ERROR,
+				"attrerror",
+				Udjat::error,
+				N_( "Attribute error on ${name}" ),
+				N_( "At least one attribute reached its error level on ${name}" )
+			},
+			{
+				Smart::ARRAY_RISK,
+				"arrayrisk",
+				Udjat::error,
+				N_( "Degraded array member at risk on ${name}" ),
+				N_( "The RAID array is degraded or rebuilding and the disk reports a health warning on ${name}" )
+			},
+			{
+				Smart::ENDURANCE_WARNING,
+				"endurance",
+				Udjat::warning,
+				N_( "SSD wearing out on ${name}" ),
+				N_( "The projected remaining write endurance is below the warning limit on ${name}" )
+			},
+			{
+				Smart::CONTROLLER_FAILURE,
+				"controller",
+				Udjat::unimportant,
+				N_( "Host adapter failing on ${name}" ),
+				N_( "The failure on ${name} is part of a correlated failure on its host adapter, reported there" )
+			},
+			{
+				Smart::PREDICTED_FAILURE,
+				"predicted",
+				Udjat::warning,
+				N_( "Failure predicted on ${name}" ),
+				N_( "The bad sector or pre-fail trend on ${name} is expected to reach its threshold soon" )
+			},
 
 		};
 
@@ -147,6 +253,37 @@
 			if(predefined_states[ix].value == value) {
 
 				// Found internal state, use it.
+
+				if(compact) {
+
+					// Compact mode, share the state with all disks.
+					static std::mutex guard;
+					static std::shared_ptr<Abstract::State> shared[N_ELEMENTS(predefined_states)];
+
+					std::lock_guard<std::mutex> lock(guard);
+
+					if(!shared[ix]) {
+#ifdef GETTEXT_PACKAGE
+						string summary{anonymous(dgettext(GETTEXT_PACKAGE,predefined_states[ix].summary))};
+						string body{anonymous(dgettext(GETTEXT_PACKAGE,predefined_states[ix].body))};
+#else
+						string summary{anonymous(predefined_states[ix].summary)};
+						string body{anonymous(predefined_states[ix].body)};
+#endif // GETTEXT_PACKAGE
+						shared[ix] =
+							make_shared<Udjat::State<unsigned short>>(
+								predefined_states[ix].name,
+								predefined_states[ix].value,
+								predefined_states[ix].level,
+								Quark(summary).c_str(),
+								Quark(body).c_str()
+							);
+					}
+
+					return shared[ix];
+
+				}
+
 #ifdef GETTEXT_PACKAGE
 				String summary{dgettext(GETTEXT_PACKAGE,predefined_states[ix].summary)};
 				String body{dgettext(GETTEXT_PACKAGE,predefined_states[ix].body)};
@@ -269,36 +406,48 @@
 
 	void Smart::Agent::init() {
 
+		paths.push_back(getDeviceName());
+
 		Object::properties.icon = "drive-harddisk";
 
 		if(!(Object::properties.label && *Object::properties.label)) {
 			string label{"Hard disk "};
 
-			const char * ptr = strrchr(this->devicename,'/');
+			const char * ptr = strrchr(getDeviceName(),'/');
 			if(ptr) {
 				label += (ptr+1);
 			} else {
-				label += devicename;
+				label += getDeviceName();
 			}
 
-			Object::properties.label = Quark(label).c_str();
+			if(compact) {
+				Object::properties.label = Strings::getInstance().get(label,"Hard disk");
+			} else {
+				Object::properties.label = Quark(label).c_str();
+			}
 		}
 
 		// Get data from disk.
 
 		try {
 
-			Smart::Disk disk(devicename);
+			Smart::Disk disk(getDeviceName());
 
-			auto ipd = disk.read().identify();
+			if(disk.identify_is_available()) {
+				auto ipd = disk.identify();
+				info.serial = ipd->serial;
+				info.firmware = ipd->firmware;
+				info.model = ipd->model;
+			}
 
-			string summary{ipd->model};
+			string summary{info.model};
 
 			try {
 
-				string sz = disk.formattedSize();
+				info.bytes = disk.size();
+				info.size = disk.formattedSize();
 
-				summary += " (" + sz + ")";
+				summary += " (" + info.size + ")";
 
 			} catch(const std::exception &e) {
 
@@ -306,7 +455,12 @@
 
 			}
 
-			Object::properties.summary = Quark(summary).c_str();
+			if(compact) {
+				// Disks of the same model share the summary.
+				Object::properties.summary = Strings::getInstance().get(summary);
+			} else {
+				Object::properties.summary = Quark(summary).c_str();
+			}
 
 		} catch(const std::exception &e) {
 
@@ -316,62 +470,890 @@
 
 	}
 
-	/// @brief Get device status, update internal state.
-	bool Smart::Agent::refresh() {
+	unsigned short Smart::Agent::evaluate(Smart::Disk &disk, unsigned short overall) {
+
+		time_t now = time(nullptr);
+
+		// Single pass over the parsed attributes.
+		uint8_t margin = 0xFF;
+		AttributeEvaluator::Result result;
+
+		// Endurance, NAND writes and the life left (from the best wear attribute available).
+		uint64_t nand = 0;
+		float life = -1;
+		int rank = 0;
+
+		disk.attributes([this,&margin,&result,&nand,&life,&rank](const SkSmartAttributeParsedData &a) {
+
+			evaluator.evaluate(a,result);
+
+			if(endurance.tracker && a.current_value_valid) {
+
+				static const uint8_t wear[] = { 0xE7, 0xE9, 0xB1 };	// ssd-life-left, media-wearout-indicator, wear-leveling-count.
+
+				uint64_t raw = 0;
+				for(size_t ix = 0; ix < 6; ix++) {
+					raw |= ((uint64_t) a.raw[ix]) << (ix * 8);
+				}
+
+				if(a.id == 0xF9) {
+					nand = raw;
+				}
+
+				// Only plausible values: a percentage, and on E9 not a counter (it's the NAND GiB
+				// written on SandForce, Kingston and Phison controllers).
+				bool plausible =
+					a.current_value <= 100
+					&& (a.pretty_unit == SK_SMART_ATTRIBUTE_UNIT_PERCENT || a.id != 0xE9 || raw <= 100);
+
+				for(int ix = 0; plausible && ix < (int) N_ELEMENTS(wear); ix++) {
+					if(a.id == wear[ix] && (!rank || rank > ix+1)) {
+						life = (float) a.current_value;
+						rank = ix+1;
+					}
+				}
+
+			}
+
+			if(a.prefailure && a.threshold_valid && a.current_value_valid) {
+				uint8_t value = (a.current_value > a.threshold ? a.current_value - a.threshold : 0);
+				if(value < margin) {
+					margin = value;
+				}
+			}
+
+		});
+
+		attribute = result;
 
+		// Optional, SSDs without attributes 5 and 197 have no bad sector count.
 		try {
 
-			set(Smart::Disk(devicename).read().getOverral());
+			uint64_t bad = disk.badsectors();
+			if(bad != badsectors) {
+				badsectors = bad;
+				Events::getInstance().push_back(name(),"badsectors",std::to_string(bad));
+			}
+
+			trend.badsectors.push_back((double) bad,now);
+
+		} catch(const std::system_error &e) {
+
+			if(e.code().value() != ENOENT) {
+				throw;
+			}
+
+			badsectors = 0;
+
+		}
+
+		if(margin != 0xFF) {
+			trend.prefail.push_back((double) margin,now);
+		}
+
+		if(endurance.tracker) {
+
+			uint64_t poweron = 0;
+			try {
+				poweron = disk.poweron() / 1000;
+			} catch(...) {
+			}
+
+			endurance.tracker->push_back(now,nand,life,poweron);
+
+		}
+
+		if(!Smart::Disk::good((SkSmartOverall) overall)) {
+			return overall;
+		}
+
+		if(attribute.level >= Udjat::error) {
+			return Smart::ATTRIBUTE_ERROR;
+		}
+
+		if(attribute.level >= Udjat::warning) {
+			return Smart::ATTRIBUTE_WARNING;
+		}
+
+		if(trend.window) {
+			for(uint64_t seconds : { trend.badsectors.predict(trend.limit,now), trend.prefail.predict(0,now) }) {
+				if(seconds && ((time_t) seconds) < trend.window) {
+					return Smart::PREDICTED_FAILURE;
+				}
+			}
+		}
+
+		if(endurance.tracker && endurance.warning) {
+			uint64_t seconds = 0;
+			if(endurance.tracker->remaining(seconds) && ((time_t) seconds) < endurance.warning) {
+				return Smart::ENDURANCE_WARNING;
+			}
+		}
+
+		return overall;
+
+	}
+
+	bool Smart::Agent::resync() noexcept {
+
+		if(!raid.array) {
+			return false;
+		}
+
+		Array::Status status = raid.array->status();
+
+		if(status.degraded != raid.degraded) {
+			raid.degraded = status.degraded;
+			Events::getInstance().push_back(name(),"array",status.degraded ? "degraded" : "healthy");
+		}
+
+		if(raid.degraded) {
+			// Degraded or rebuilding, full read on every refresh.
+			tier.countdown = 0;
+			return false;
+		}
+
+		if(!status.syncing || (time(nullptr) - deferral.last) >= deferral.max) {
+			return false;
+		}
+
+		// Resync or check in progress on a healthy array, stay out of the way.
+		deferral.count++;
+		return true;
+
+	}
+
+	bool Smart::Agent::defer() noexcept {
+
+		if(!deferral.load) {
+			return false;
+		}
+
+		Load::Value load = deferral.load->sample();
+
+		bool busy =
+			(deferral.utilization && load.utilization >= (float) deferral.utilization)
+			|| (deferral.inflight && load.inflight >= (float) deferral.inflight);
+
+		if(!busy || (time(nullptr) - deferral.last) >= deferral.max) {
+			return false;
+		}
+
+		deferral.count++;
+
+#ifdef DEBUG
+		trace() << "Deferring S.M.A.R.T. read, utilization=" << load.utilization << "% inflight=" << load.inflight << endl;
+#endif // DEBUG
+
+		return true;
+
+	}
+
+	bool Smart::Agent::failover() noexcept {
+
+		if(paths.size() < 2) {
+			return false;
+		}
+
+		for(size_t ix = 0; ix < paths.size(); ix++) {
+
+			if(paths[ix] != getDeviceName()) {
+				continue;
+			}
+
+			const char *next = paths[(ix+1) % paths.size()];
+			devicename = next;
+
+			// The samplers read per path statistics, move them to the active one.
+			try {
+
+				if(endurance.tracker) {
+					endurance.tracker->rebind(next);
+				}
+
+				if(thermal) {
+					thermal->rebind(next);
+				}
+
+				if(deferral.load) {
+					deferral.load->rebind(next);
+				}
+
+				if(unit) {
+					Udjat::Disk::Stat(next).reset(stats);
+				}
+
+			} catch(const std::exception &e) {
+
+				warning() << "Error '" << e.what() << "' moving the samplers to " << next << endl;
+
+			}
+
+			return true;
+
+		}
+
+		return false;
+
+	}
+
+	void Smart::Agent::poll() {
+
+		Smart::Disk disk(getDeviceName());
+
+		if(tier.countdown && !failing && disk.status()) {
+
+			// Fast tier, the device reports good health; keep the state from the last full read.
+			tier.countdown--;
+
+		} else {
+
+			// Slow tier (or the fast one reported a problem), do a full read.
+			disk.read();
+
+			unsigned short previous = super::get();
+			unsigned short value = evaluate(disk,disk.getOverral());
+
+			if(raid.degraded && (value == SK_SMART_OVERALL_BAD_SECTOR || value == Smart::ATTRIBUTE_WARNING || value == Smart::PREDICTED_FAILURE)) {
+				// No redundancy left on the array, a warning on a member is an error.
+				value = Smart::ARRAY_RISK;
+			}
+
+			set(value);
+
+			record(disk);
+			capture(disk);
+
+			if(value != previous || failing) {
+				Events::getInstance().push_back(name(),"state",computeState()->name());
+				failing = false;
+			}
+
+			// Members of healthy arrays are read less often.
+			unsigned int interval = ((raid.array && !raid.degraded) ? std::max(tier.interval,raid.interval) : tier.interval);
+			tier.countdown = (interval > 1 ? interval - 1 : 0);
+
+		}
+
+	}
+
+	void Smart::Agent::encode(CBOR &cbor) {
+
+		auto state = this->state();
+
+		cbor.map();
+
+		cbor.text(CBOR::KEY_NAME,name());
+		cbor.text(CBOR::KEY_DEVICE,getDeviceName());
+		if(state) {
+			cbor.text(CBOR::KEY_STATE,state->name());
+			cbor.integer(CBOR::KEY_LEVEL,state->level());
+		}
+		cbor.integer(CBOR::KEY_VALUE,super::get());
+		cbor.boolean(CBOR::KEY_FAILING,failing);
+
+		if(snapshot.timestamp) {
+			cbor.integer(CBOR::KEY_TIMESTAMP,snapshot.timestamp);
+			if(snapshot.temperature) {
+				cbor.integer(CBOR::KEY_TEMPERATURE,snapshot.temperature);
+			}
+			cbor.integer(CBOR::KEY_BADSECTORS,badsectors);
+			cbor.integer(CBOR::KEY_POWERON,snapshot.poweron);
+			cbor.integer(CBOR::KEY_POWERCICLE,snapshot.powercicle);
+		}
+
+		if(info.bytes) {
+			cbor.integer(CBOR::KEY_SIZE,info.bytes);
+		}
+
+		cbor.text(CBOR::KEY_SERIAL,info.serial);
+		cbor.text(CBOR::KEY_FIRMWARE,info.firmware);
+		cbor.text(CBOR::KEY_MODEL,info.model);
+
+		if(unit) {
+			cbor.real(CBOR::KEY_READ,stats.read / unit->value);
+			cbor.real(CBOR::KEY_WRITE,stats.write / unit->value);
+		}
+
+		if(attribute.id) {
+			cbor.integer(CBOR::KEY_ATTRIBUTE,attribute.id);
+			cbor.integer(CBOR::KEY_ATTRIBUTE_VALUE,attribute.value);
+		}
+
+		cbor.integer(CBOR::KEY_BADSECTORS_FORECAST,trend.badsectors.predict(trend.limit));
+		cbor.integer(CBOR::KEY_PREFAIL_FORECAST,trend.prefail.predict(0));
+
+		if(deferral.load || raid.array) {
+			cbor.integer(CBOR::KEY_DEFERRED,deferral.count);
+		}
+
+		if(endurance.tracker) {
+			Endurance::Sample sample = endurance.tracker->get();
+			cbor.integer(CBOR::KEY_HOST_WRITTEN,sample.host);
+			if(sample.life >= 0) {
+				cbor.real(CBOR::KEY_LIFE,sample.life);
+			}
+			uint64_t seconds = 0;
+			if(endurance.tracker->remaining(seconds)) {
+				cbor.integer(CBOR::KEY_REMAINING,seconds);
+			}
+		}
+
+		cbor.end();
+
+	}
+
+	void Smart::Agent::capture(Smart::Disk &disk) noexcept {
+
+		if(!blobs.limit) {
+			return;
+		}
+
+		try {
+
+			// Distinct by the failure relevant data only; the raw data changes on every
+			// read (power on hours, temperature).
+			unsigned short value = super::get();
+
+			uint64_t signature = 0xcbf29ce484222325ULL;
+			auto hash = [&signature](uint64_t v) {
+				for(size_t ix = 0; ix < 8; ix++) {
+					signature ^= (uint8_t) (v >> (ix * 8));
+					signature *= 0x100000001b3ULL;
+				}
+			};
+
+			hash(value);
+			hash(badsectors);
+
+			disk.attributes([&hash](const SkSmartAttributeParsedData &a) {
+
+				hash((((uint64_t) a.id) << 8) | (a.good_now_valid && !a.good_now ? 1 : 0) | (a.good_in_the_past_valid && !a.good_in_the_past ? 2 : 0));
+
+				switch(a.id) {
+				case 0x05:	// reallocated-sector-count
+				case 0xC4:	// reallocated-event-count
+				case 0xC5:	// current-pending-sector
+				case 0xC6:	// offline-uncorrectable
+					{
+						uint64_t raw = 0;
+						for(size_t ix = 0; ix < 6; ix++) {
+							raw |= ((uint64_t) a.raw[ix]) << (ix * 8);
+						}
+						hash(raw);
+					}
+					break;
+				}
+
+			});
+
+			{
+				std::lock_guard<std::mutex> lock(blobs.guard);
+				if(!blobs.values.empty() && blobs.values.back().signature == signature) {
+					// Unchanged, keep the first capture (and its encoding).
+					return;
+				}
+			}
+
+			auto blob = make_shared<Blob>(disk.blob());
+			if(blob->empty()) {
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(blobs.guard);
+
+			// Pin the transitions, they're the captures worth replaying.
+			bool pinned = (blobs.values.empty() || value != blobs.captured);
+			blobs.captured = value;
+
+			if(blobs.values.size() >= blobs.limit) {
+
+				// Drop the oldest unpinned capture (or the oldest one if all are pinned).
+				auto victim = blobs.values.begin();
+				for(auto it = blobs.values.begin(); it != blobs.values.end(); it++) {
+					if(!it->pinned) {
+						victim = it;
+						break;
+					}
+				}
+
+				blobs.values.erase(victim);
+
+			}
+
+			blobs.values.push_back({blob,signature,pinned});
+
+		} catch(const std::system_error &e) {
+
+			if(e.code().value() == ENOTSUP) {
+				// No raw data on this backend, don't try again.
+				std::lock_guard<std::mutex> lock(blobs.guard);
+				blobs.limit = 0;
+			}
+
+			trace() << "Can't capture raw data: " << e.what() << endl;
 
 		} catch(const std::exception &e) {
 
-			failed(Logger::Message(_("Can't get overall state of {}"),devicename).c_str(), e);
+			trace() << "Can't capture raw data: " << e.what() << endl;
+
+		}
+
+	}
+
+	void Smart::Agent::record(Smart::Disk &disk) noexcept {
+
+		History::Sample sample;
+
+		sample.timestamp = (uint64_t) time(nullptr);
+		sample.value = super::get();
+		sample.badsectors = badsectors;
+
+		// Optional values, not available on every device.
+		try {
+			Temperature temperature = disk.temperature();
+			if(!temperature.empty()) {
+				sample.temperature = (uint64_t) (temperature.as_kelvin() * 1000);
+			}
+		} catch(...) {
+		}
+
+		try {
+			sample.poweron = disk.poweron();
+		} catch(...) {
+		}
+
+		try {
+			sample.powercicle = disk.powercicle();
+		} catch(...) {
+		}
+
+		snapshot.timestamp = (time_t) sample.timestamp;
+		snapshot.temperature = sample.temperature;
+		snapshot.poweron = sample.poweron;
+		snapshot.powercicle = sample.powercicle;
+
+		if(!(history && History::getInstance().enabled())) {
+			return;
+		}
+
+		try {
+			disk.attributes([&sample](const SkSmartAttributeParsedData &a) {
+				if(sample.attributes < History::MAX_ATTRIBUTES) {
+					uint64_t raw = 0;
+					for(size_t ix = 0; ix < 6; ix++) {
+						raw |= ((uint64_t) a.raw[ix]) << (ix * 8);
+					}
+					sample.attribute[sample.attributes].id = a.id;
+					sample.attribute[sample.attributes].raw = raw;
+					sample.attributes++;
+				}
+			});
+		} catch(...) {
+		}
+
+		History::getInstance().push_back(name(),sample);
+
+	}
+
+	/// @brief Get device status, update internal state.
+	bool Smart::Agent::refresh() {
+
+		if(controller && controller->suspended()) {
+
+			// Correlated failure on the host adapter, don't hammer it.
+			if(failing) {
+				// Failed before the back off started.
+				fold();
+			}
+
+		} else if(!(defer() || resync())) {
+
+			deferral.last = time(nullptr);
+
+			// Try each path once, starting on the active one.
+			for(size_t attempt = 0; attempt < paths.size(); attempt++) {
+
+				try {
+
+					poll();
+
+					if(controller) {
+						controller->succeeded(this);
+					}
+
+					break;
+
+				} catch(const std::exception &e) {
+
+					if(attempt+1 < paths.size() && failover()) {
+						warning() << "Error '" << e.what() << "', switching to " << getDeviceName() << endl;
+						Events::getInstance().push_back(name(),"device",getDeviceName());
+						continue;
+					}
+
+					// Next successful poll must be a full read, to replace the failed state.
+					tier.countdown = 0;
+
+					Controller::Verdict verdict = (controller ? controller->failed(this) : Controller::Isolated);
+
+					if(verdict == Controller::Isolated) {
+
+						failed(Logger::Message(_("Can't get overall state of {}"),getDeviceName()).c_str(), e);
+
+						if(!failing) {
+							failing = true;
+							Events::getInstance().push_back(name(),"state","failed");
+						}
+
+					} else {
+
+						if(verdict == Controller::Started) {
+							// Many disks failing together, report it once for the controller.
+							error() << "Correlated failures on host adapter " << controller->id << ", backing off" << endl;
+							Events::getInstance().push_back(Quark(controller->id).c_str(),"state","correlated");
+						}
+
+						fold();
+
+					}
+
+				}
+
+			}
 
 		}
 
 		if(unit) {
-			Udjat::Disk::Stat(devicename).compute(stats);
+			// On the active path, failover() restarts the counters.
+			Udjat::Disk::Stat(getDeviceName()).compute(stats);
 
 #ifdef DEBUG
 			trace() << "Read=" << (stats.read / unit->value) << " Write=" << (stats.write / unit->value) << endl;
 #endif // DEBUG
 		}
 
+		// Update the aggregated states.
+		for(auto &aggregation : aggregations) {
+			auto agent = aggregation.lock();
+			if(agent) {
+				agent->refresh();
+			}
+		}
+
 		return true;
 
 	}
 
+	void Smart::Agent::fold() {
+
+#ifdef DEBUG
+		if(super::get() != Smart::CONTROLLER_FAILURE) {
+			trace() << "Failure folded into host adapter " << controller->id << endl;
+		}
+#endif // DEBUG
+
+		failing = false;
+		set(Smart::CONTROLLER_FAILURE);
+
+	}
+
+	void Smart::Agent::attach(const std::shared_ptr<Abstract::Agent> &aggregation) {
+
+		// Forget the ones from a replaced configuration.
+		for(auto it = aggregations.begin(); it != aggregations.end();) {
+			if(it->expired()) {
+				it = aggregations.erase(it);
+			} else {
+				it++;
+			}
+		}
+
+		aggregations.push_back(aggregation);
+
+	}
+
 	/// @brief Export device info.
 	void Smart::Agent::get(const Udjat::Request &request, Udjat::Response &response) {
 
+		if(Events::getInstance().get(request,response,name())) {
+			// Event request, export only the changes.
+			return;
+		}
+
+		if(Smart::query(request,"format") == "cbor") {
+
+			// Binary response, from the cached values.
+			CBOR &cbor = CBOR::getInstance();
+
+			cbor.map(3);
+			cbor.integer(CBOR::ENVELOPE_SCHEMA,CBOR::SCHEMA);
+			cbor.integer(CBOR::ENVELOPE_TIMESTAMP,time(nullptr));
+			cbor.integer(CBOR::ENVELOPE_DISKS).array(1);
+			encode(cbor);
+
+			static thread_local string payload;
+			base64(cbor.data(),cbor.size(),payload);
+
+			response["schema"] = CBOR::SCHEMA;
+			response["cbor"] = payload;
+			return;
+
+		}
+
+		uint16_t fields = Smart::fields(request);
+
 		Udjat::Abstract::Agent::get(request,response);
 
+		{
+			// History range query ('?history=<from>[,<to>]', unix timestamps).
+			string range = Smart::query(request,"history");
+			if(!range.empty()) {
+
+				uint64_t from = strtoull(range.c_str(),nullptr,10);
+				const char *ptr = strchr(range.c_str(),',');
+				uint64_t to = (ptr ? strtoull(ptr+1,nullptr,10) : (uint64_t) time(nullptr));
+
+				Udjat::Value &samples = response["history"];
+
+				History::getInstance().get(name(),from,to,[&samples](const History::Sample &sample){
+
+					Udjat::Value &value = samples.append();
+
+					value["timestamp"] = sample.timestamp;
+					value["value"] = sample.value;
+					value["temperature"] = sample.temperature;
+					value["badsectors"] = sample.badsectors;
+					value["poweron"] = sample.poweron;
+					value["powercicle"] = sample.powercicle;
+
+					Udjat::Value &attributes = value["attributes"];
+					for(size_t ix = 0; ix < sample.attributes; ix++) {
+						attributes[std::to_string(sample.attribute[ix].id).c_str()] = sample.attribute[ix].raw;
+					}
+
+				});
+
+			}
+		}
+
+		if(fields & Smart::FIELD_SIZE) {
+			response["size"] = info.size;
+		}
+
+		if(fields & Smart::FIELD_PATHS) {
+			response["device"] = getDeviceName();
+			response["array"] = (raid.array ? raid.array->name : "");
+			Udjat::Value &values = response["paths"];
+			for(const char *path : paths) {
+				values.append() = path;
+			}
+		}
+
+		if(fields & Smart::FIELD_IDENTIFY) {
+			response["serial"] = info.serial;
+			response["firmware"] = info.firmware;
+			response["model"] = info.model;
+		}
+
+		if(fields & Smart::FIELD_ATTRIBUTE) {
+			if(attribute.id) {
+				const AttributeDefinition *definition = AttributeDefinition::find(attribute.id);
+				response["attribute"] = (definition ? definition->name : std::to_string(attribute.id).c_str());
+				response["attribute-value"] = attribute.value;
+			} else {
+				response["attribute"] = "";
+				response["attribute-value"] = 0;
+			}
+		}
+
+		if(fields & Smart::FIELD_FORECAST) {
+			// Predicted seconds to threshold (0 if there's no failure trend).
+			response["badsectors-forecast"] = trend.badsectors.predict(trend.limit);
+			response["prefail-forecast"] = trend.prefail.predict(0);
+		}
+
+		if((deferral.load || raid.array) && (fields & Smart::FIELD_DEFERRED)) {
+			response["deferred"] = deferral.count;
+		}
+
+		if(thermal) {
+
+			char buffer[24];
+
+			Temperature sample;
+			if((fields & Smart::FIELD_TEMPERATURE) && thermal->get(sample)) {
+				// Sampled, no need for a S.M.A.R.T. read.
+				response["temperature"] = sample.to_string(buffer,sizeof(buffer));
+				fields &= ~Smart::FIELD_TEMPERATURE;
+			}
+
+			if(fields & Smart::FIELD_THERMAL) {
+
+				Udjat::Value &windows = response["thermal"];
+
+				time_t seconds;
+				Thermal::Window::Value value;
+
+				for(size_t ix = 0; thermal->get(ix,seconds,value); ix++) {
+
+					Udjat::Value &window = windows.append();
+
+					window["seconds"] = (unsigned int) seconds;
+					window["samples"] = value.count;
+
+					Temperature temperature{value.min,Temperature::Celsius};
+					window["min"] = temperature.set(Smart::unity()).to_string(buffer,sizeof(buffer));
+					window["max"] = temperature.set(value.max,Temperature::Celsius).set(Smart::unity()).to_string(buffer,sizeof(buffer));
+					window["avg"] = temperature.set(value.avg,Temperature::Celsius).set(Smart::unity()).to_string(buffer,sizeof(buffer));
+
+				}
+
+			}
+
+		}
+
+		if(fields & Smart::FIELD_MEMORY) {
+
+			// Approximate, heap and pooled memory owned by this agent.
+			Udjat::Value &memory = response["memory"];
+
+			size_t strings = info.size.size() + info.serial.size() + info.firmware.size() + info.model.size();
+			if(!compact) {
+				strings += strlen(Object::properties.label) + strlen(Object::properties.summary);
+			}
+
+			size_t raw = 0;
+			{
+				std::lock_guard<std::mutex> lock(blobs.guard);
+				for(auto &capture : blobs.values) {
+					raw += sizeof(Blob) + capture.blob->raw().size();
+				}
+			}
+
+			size_t values[] = {
+				sizeof(Smart::Agent),
+				states.size() * sizeof(Udjat::State<unsigned short>),
+				strings,
+				paths.capacity() * sizeof(const char *),
+				evaluator.size(),
+				thermal ? sizeof(Thermal) : 0,
+				deferral.load ? sizeof(Load) : 0,
+				raw,
+				endurance.tracker ? sizeof(Endurance) : 0
+			};
+
+			memory["compact"] = compact;
+			memory["agent"] = values[0];
+			memory["states"] = values[1];
+			memory["strings"] = values[2];
+			memory["paths"] = values[3];
+			memory["evaluator"] = values[4];
+			memory["thermal"] = values[5];
+			memory["load"] = values[6];
+			memory["blobs"] = values[7];
+			memory["endurance"] = values[8];
+
+			size_t total = 0;
+			for(size_t value : values) {
+				total += value;
+			}
+			memory["total"] = total;
+
+		}
+
+		if(endurance.tracker && (fields & Smart::FIELD_ENDURANCE)) {
+
+			Endurance::Sample sample = endurance.tracker->get();
+
+			Udjat::Value &value = response["endurance"];
+
+			value["host-written"] = sample.host;
+			value["nand-written"] = sample.nand;
+			value["life"] = sample.life;
+			uint64_t seconds = 0;
+			if(endurance.tracker->remaining(seconds)) {
+				value["remaining"] = seconds;
+			}
+
+			Udjat::Value &windows = value["windows"];
+
+			Endurance::Value rates;
+			for(size_t ix = 0; endurance.tracker->get(ix,rates); ix++) {
+
+				Udjat::Value &window = windows.append();
+
+				window["seconds"] = (unsigned int) rates.seconds;
+				window["write"] = rates.write;
+				window["waf"] = rates.waf;
+				window["wear"] = rates.wear;
+				if(rates.projected) {
+					window["remaining"] = rates.remaining;
+				}
+
+			}
+
+		}
+
+		if(fields & Smart::FIELD_BLOB) {
+
+			// Last captured raw data, base64 encoded; encoded only once per capture.
+			std::lock_guard<std::mutex> lock(blobs.guard);
+
+			if(blobs.values.empty()) {
+				response["blob"] = "";
+				response["blob-captured"] = 0;
+			} else {
+				response["blob"] = blobs.values.back().blob->encoded();
+				response["blob-captured"] = (uint64_t) blobs.values.back().blob->captured();
+			}
+
+			if(blobs.limit > 1) {
+
+				// All retained blobs, oldest first.
+				Udjat::Value &values = response["blobs"];
+
+				for(auto &capture : blobs.values) {
+					Udjat::Value &value = values.append();
+					value["captured"] = (uint64_t) capture.blob->captured();
+					value["pinned"] = capture.pinned;
+					value["data"] = capture.blob->encoded();
+				}
+
+			}
+
+		}
+
+		if(unit && (fields & Smart::FIELD_IOSTATS)) {
+			response["read"] = stats.read / unit->value;
+			response["write"] = stats.write / unit->value;
+		}
+
+		if(!(fields & Smart::FIELD_DISK_DATA)) {
+			// Nothing else to export, don't touch the disk.
+			return;
+		}
+
 		try {
 
-			Smart::Disk disk(devicename);
+			Smart::Disk disk(getDeviceName(),Smart::Disk::Request);
 			disk.read();
 
-			response["temperature"] = disk.temperature().to_string().c_str();
-			response["size"] = disk.formattedSize();
+			if(fields & Smart::FIELD_TEMPERATURE) {
+				char buffer[24];
+				response["temperature"] = disk.temperature().to_string(buffer,sizeof(buffer));
+			}
 
-			if(disk.identify_is_available()) {
-				auto ipd = disk.read().identify();
-				response["serial"] = ipd->serial;
-				response["firmware"] = ipd->firmware;
-				response["model"] = ipd->model;
-			} else {
-				response["serial"] = "";
-				response["firmware"] = "";
-				response["model"] = "";
+			if(fields & Smart::FIELD_BADSECTORS) {
+				response["badsectors"] = disk.badsectors();
 			}
 
-			response["badsectors"] = disk.badsectors();
-			response["poweron"] = disk.poweron();
-			response["powercicle"] = disk.powercicle();
+			if(fields & Smart::FIELD_POWERON) {
+				response["poweron"] = disk.poweron();
+			}
 
-			if(unit) {
-				response["read"] = stats.read / unit->value;
-				response["write"] = stats.write / unit->value;
+			if(fields & Smart::FIELD_POWERCICLE) {
+				response["powercicle"] = disk.powercicle();
 			}
 
 		} catch(const exception &e) {
@@ -385,6 +1367,25 @@
 	Smart::Agent::~Agent() {
 	}
 
+	void Smart::Agent::start() {
+		if(running++ == 0) {
+			Abstract::Agent::start();
+		}
+	}
+
+	void Smart::Agent::stop() {
+
+		unsigned int value = running.load();
+		while(value && !running.compare_exchange_weak(value,value-1)) {
+		}
+
+		if(value == 1) {
+			// Last configuration using the agent.
+			Abstract::Agent::stop();
+		}
+
+	}
+
 
  }
 
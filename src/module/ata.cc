@@ -0,0 +1,221 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the libatasmart backend.
+  *
+  * <http://git.0pointer.net/libatasmart.git/tree/atasmart.c>
+  *
+  */
+
+ #include "private.h"
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Smart::ATABackend::ATABackend(const char *name) {
+
+		if(sk_disk_open(name, &d) < 0) {
+			throw system_error(errno, system_category(), string{"Can't open "} + name);
+		}
+
+	}
+
+	Smart::ATABackend::ATABackend(const std::string &blob) {
+
+		if(sk_disk_open(NULL, &d) < 0) {
+			throw system_error(errno, system_category(), "Can't create S.M.A.R.T. disk");
+		}
+
+		if(sk_disk_set_blob(d, blob.data(), blob.size()) < 0) {
+			int err = errno;
+			sk_disk_free(d);
+			throw system_error(err, system_category(), "Invalid S.M.A.R.T. blob");
+		}
+
+	}
+
+	Smart::ATABackend::~ATABackend() {
+		sk_disk_free(d);
+	}
+
+	void Smart::ATABackend::read() {
+
+		// TODO: Reading SMART data might cause the disk to wake up from sleep. Hence from monitoring daemons make sure to call sk_disk_check_power_mode() to check wether the disk is sleeping and skip the read if so
+
+		if(sk_disk_smart_read_data(d) < 0) {
+			throw system_error(errno, system_category(), "Can't read S.M.A.R.T. data");
+		}
+
+	}
+
+	bool Smart::ATABackend::status() {
+
+		// SMART RETURN STATUS, doesn't transfer the attribute data.
+		SkBool good = 0;
+
+		if(sk_disk_smart_status(d,&good) < 0) {
+			throw system_error(errno, system_category(), "Can't get S.M.A.R.T. status");
+		}
+
+		return good != 0;
+
+	}
+
+	bool Smart::ATABackend::identify_is_available() {
+
+		SkBool available = 0;
+
+		if(sk_disk_identify_is_available(d,&available) < 0) {
+			throw system_error(errno, system_category(), "Can't teste if identify is available");
+		}
+
+		return available != 0;
+
+	}
+
+	const SkIdentifyParsedData * Smart::ATABackend::identify() {
+		const SkIdentifyParsedData *ipd;
+		if(sk_disk_identify_parse(d, &ipd) < 0) {
+			throw system_error(errno, system_category(), "Can't parse S.M.A.R.T. identify");
+		}
+		return ipd;
+	}
+
+	SkSmartOverall Smart::ATABackend::overall() {
+
+		SkSmartOverall overall;
+
+		if (sk_disk_smart_get_overall(d, &overall) < 0) {
+			throw system_error(errno, system_category(), "Can't get S.M.A.R.T. overall state");
+		}
+
+		return overall;
+
+	}
+
+	bool Smart::ATABackend::is_awake() {
+		SkBool awake = 0;
+
+		if(sk_disk_check_sleep_mode(d,&awake) < 0) {
+			throw system_error(errno, system_category(), "Can't get disk awake state");
+		}
+
+		return awake != 0;
+
+	}
+
+	uint64_t Smart::ATABackend::size() {
+
+		uint64_t value;
+
+		if(sk_disk_get_size(d,&value) < 0) {
+			throw system_error(errno, system_category(), "Can't get S.M.A.R.T. disk size");
+		}
+
+		return value;
+
+	}
+
+	uint64_t Smart::ATABackend::badsectors() {
+
+		uint64_t value;
+
+		if(sk_disk_smart_get_bad(d,&value) < 0) {
+			throw system_error(errno, system_category(), "Can't get bad sectors");
+		}
+
+		return value;
+
+	}
+
+	uint64_t Smart::ATABackend::poweron() {
+
+		uint64_t mseconds;
+
+		if(sk_disk_smart_get_power_on(d,&mseconds) < 0) {
+			if(errno == ENOENT) {
+				return 0;
+			}
+			throw system_error(errno, system_category(), "Can't get power on");
+		}
+
+		return mseconds;
+
+	}
+
+	uint64_t Smart::ATABackend::powercicle() {
+
+		uint64_t value;
+
+		if(sk_disk_smart_get_power_cycle(d,&value) < 0) {
+			throw system_error(errno, system_category(), "Can't get power cicle");
+		}
+
+		return value;
+
+	}
+
+	uint64_t Smart::ATABackend::temperature() {
+
+		uint64_t value;
+		if(sk_disk_smart_get_temperature(d,&value) < 0) {
+			if(errno == ENOENT) {
+				return 0;
+			}
+			throw system_error(errno, system_category(), "Can't get temperature");
+		}
+
+		return value;
+
+	}
+
+	std::string Smart::ATABackend::blob() {
+
+		const void *data = nullptr;
+		size_t size = 0;
+
+		if(sk_disk_get_blob(d,&data,&size) < 0) {
+			throw system_error(errno, system_category(), "Can't get S.M.A.R.T. blob");
+		}
+
+		return string{(const char *) data,size};
+
+	}
+
+	void Smart::ATABackend::attributes(Callback call, void *userdata) {
+
+		struct Context {
+			Callback call;
+			void *userdata;
+		} context{call,userdata};
+
+		auto callback = [](SkDisk UDJAT_UNUSED(*d), const SkSmartAttributeParsedData *a, void *userdata) {
+			Context *context = (Context *) userdata;
+			context->call(*a,context->userdata);
+		};
+
+		if(sk_disk_smart_parse_attributes(d, callback, (void *) &context) < 0) {
+			throw system_error(errno, system_category(), "Can't parse S.M.A.R.T. attributes");
+		}
+
+	}
+
+ }
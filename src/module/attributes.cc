@@ -0,0 +1,194 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the ATA attribute knowledge table.
+  *
+  * <http://git.0pointer.net/libatasmart.git/tree/atasmart.c>
+  * <https://en.wikipedia.org/wiki/S.M.A.R.T.#Known_ATA_S.M.A.R.T._attributes>
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/smart/attributes.h>
+ #include <udjat/tools/logger.h>
+ #include <strings.h>
+
+ namespace Udjat {
+
+	using Direction = Smart::AttributeDefinition::Direction;
+
+	/// @brief Well-known attributes; 'Higher' levels are in libatasmart pretty units, 'Lower' levels are normalized values.
+	static constexpr Smart::AttributeDefinition definitions[] = {
+
+		{ 0x01, "raw-read-error-rate",				true,	Direction::Lower,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0x03, "spin-up-time",						true,	Direction::Lower,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_MSECONDS	},
+		{ 0x04, "start-stop-count",					false,	Direction::None,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0x05, "reallocated-sector-count",			true,	Direction::Higher,	1,		50,		SK_SMART_ATTRIBUTE_UNIT_SECTORS		},
+		{ 0x07, "seek-error-rate",					true,	Direction::Lower,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0x09, "power-on-hours",					false,	Direction::None,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_MSECONDS	},
+		{ 0x0a, "spin-retry-count",					true,	Direction::Higher,	1,		10,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0x0c, "power-cycle-count",				false,	Direction::None,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xb1, "wear-leveling-count",				true,	Direction::Lower,	10,		5,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xb5, "program-fail-count-total",			false,	Direction::Higher,	1,		10,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xb6, "erase-fail-count-total",			false,	Direction::Higher,	1,		10,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xb8, "end-to-end-error",					false,	Direction::Higher,	0,		1,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xbb, "reported-uncorrect",				false,	Direction::Higher,	1,		10,		SK_SMART_ATTRIBUTE_UNIT_SECTORS		},
+		{ 0xbe, "airflow-temperature-celsius",		false,	Direction::Higher,	328150,	338150,	SK_SMART_ATTRIBUTE_UNIT_MKELVIN		},
+		{ 0xc2, "temperature-celsius-2",			false,	Direction::Higher,	328150,	338150,	SK_SMART_ATTRIBUTE_UNIT_MKELVIN		},
+		{ 0xc4, "reallocated-event-count",			false,	Direction::Higher,	1,		50,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xc5, "current-pending-sector",			false,	Direction::Higher,	1,		10,		SK_SMART_ATTRIBUTE_UNIT_SECTORS		},
+		{ 0xc6, "offline-uncorrectable",			false,	Direction::Higher,	1,		10,		SK_SMART_ATTRIBUTE_UNIT_SECTORS		},
+		{ 0xc7, "udma-crc-error-count",				false,	Direction::Higher,	10,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xc8, "multi-zone-error-rate",			false,	Direction::None,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xe7, "ssd-life-left",					false,	Direction::Lower,	10,		5,		SK_SMART_ATTRIBUTE_UNIT_PERCENT		},
+		{ 0xe8, "available-reserved-space",			true,	Direction::Lower,	20,		10,		SK_SMART_ATTRIBUTE_UNIT_PERCENT		},
+		{ 0xe9, "media-wearout-indicator",			false,	Direction::Lower,	10,		5,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xf1, "total-lbas-written",				false,	Direction::None,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+		{ 0xf2, "total-lbas-read",					false,	Direction::None,	0,		0,		SK_SMART_ATTRIBUTE_UNIT_NONE		},
+
+	};
+
+	/// @brief Build the attribute id to table position index.
+	static constexpr std::array<uint8_t,256> make_index() {
+		std::array<uint8_t,256> index{};
+		for(size_t ix = 0; ix < index.size(); ix++) {
+			index[ix] = 0xFF;
+		}
+		for(size_t ix = 0; ix < N_ELEMENTS(definitions); ix++) {
+			index[definitions[ix].id] = (uint8_t) ix;
+		}
+		return index;
+	}
+
+	static constexpr std::array<uint8_t,256> index = make_index();
+
+	static_assert(N_ELEMENTS(definitions) < 0xFF, "Too many attribute definitions");
+	static_assert(index[0x05] == 3, "Invalid attribute index");
+
+	const Smart::AttributeDefinition * Smart::AttributeDefinition::find(uint8_t id) noexcept {
+		uint8_t ix = index[id];
+		return (ix == 0xFF ? nullptr : definitions+ix);
+	}
+
+	void Smart::AttributeEvaluator::load(const pugi::xml_node &node) {
+
+		for(pugi::xml_node child = node.child("smart-attribute"); child; child = child.next_sibling("smart-attribute")) {
+
+			unsigned int id = child.attribute("id").as_uint(0);
+			if(!id || id > 0xFF) {
+				throw runtime_error("Invalid or missing 'id' on <smart-attribute>");
+			}
+
+			const AttributeDefinition *definition = AttributeDefinition::find((uint8_t) id);
+
+			Override entry;
+			entry.id = (uint8_t) id;
+			entry.direction = (definition ? definition->direction : Direction::Higher);
+			entry.warning = (definition ? definition->warning : 0);
+			entry.error = (definition ? definition->error : 0);
+
+			const char *direction = child.attribute("direction").as_string("");
+			if(!strcasecmp(direction,"higher")) {
+				entry.direction = Direction::Higher;
+			} else if(!strcasecmp(direction,"lower")) {
+				entry.direction = Direction::Lower;
+			} else if(!strcasecmp(direction,"none")) {
+				entry.direction = Direction::None;
+			} else if(*direction) {
+				throw runtime_error(string{"Unexpected attribute direction '"} + direction + "'");
+			}
+
+			entry.warning = child.attribute("warning").as_ullong(entry.warning);
+			entry.error = child.attribute("error").as_ullong(entry.error);
+
+			overrides.push_back(entry);
+
+		}
+
+	}
+
+	Udjat::Level Smart::AttributeEvaluator::evaluate(const SkSmartAttributeParsedData &a, uint64_t &value) const noexcept {
+
+		Direction direction = Direction::None;
+		uint64_t warning = 0, error = 0;
+
+		const AttributeDefinition *definition = AttributeDefinition::find(a.id);
+		if(definition) {
+			direction = definition->direction;
+			warning = definition->warning;
+			error = definition->error;
+		}
+
+		for(const Override &entry : overrides) {
+			if(entry.id == a.id) {
+				direction = entry.direction;
+				warning = entry.warning;
+				error = entry.error;
+				break;
+			}
+		}
+
+		switch(direction) {
+		case Direction::Higher:
+			value = a.pretty_value;
+			if(error && value >= error) {
+				return Udjat::error;
+			}
+			if(warning && value >= warning) {
+				return Udjat::warning;
+			}
+			break;
+
+		case Direction::Lower:
+			value = a.current_value;
+			if(!a.current_value_valid) {
+				break;
+			}
+			if(error && value <= error) {
+				return Udjat::error;
+			}
+			if(warning && value <= warning) {
+				return Udjat::warning;
+			}
+			break;
+
+		default:
+			value = a.pretty_value;
+
+		}
+
+		return Udjat::ready;
+
+	}
+
+	void Smart::AttributeEvaluator::evaluate(const SkSmartAttributeParsedData &a, Result &result) const noexcept {
+
+		uint64_t value = 0;
+		Udjat::Level level = evaluate(a,value);
+
+		if(level > result.level) {
+			result.level = level;
+			result.id = a.id;
+			result.value = value;
+		}
+
+	}
+
+ }
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the raw S.M.A.R.T. blob.
+  *
+  * <https://datatracker.ietf.org/doc/html/rfc4648#section-4>
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/smart/blob.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Smart::base64(const void *data, size_t length, std::string &str) {
+
+		static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+		str.clear();
+		str.reserve(((length + 2) / 3) * 4);
+
+		const uint8_t *ptr = (const uint8_t *) data;
+
+		while(length >= 3) {
+			uint32_t value = (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+			str += alphabet[(value >> 18) & 0x3F];
+			str += alphabet[(value >> 12) & 0x3F];
+			str += alphabet[(value >> 6) & 0x3F];
+			str += alphabet[value & 0x3F];
+			ptr += 3;
+			length -= 3;
+		}
+
+		if(length) {
+			uint32_t value = (ptr[0] << 16) | (length > 1 ? (ptr[1] << 8) : 0);
+			str += alphabet[(value >> 18) & 0x3F];
+			str += alphabet[(value >> 12) & 0x3F];
+			str += (length > 1 ? alphabet[(value >> 6) & 0x3F] : '=');
+			str += '=';
+		}
+
+	}
+
+	const std::string & Smart::Blob::encoded() const {
+
+		if(base64.empty() && !data.empty()) {
+			Smart::base64(data.data(),data.size(),base64);
+		}
+
+		return base64;
+
+	}
+
+ }
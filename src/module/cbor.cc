@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the CBOR encoder.
+  *
+  * <https://www.rfc-editor.org/rfc/rfc8949>
+  *
+  */
+
+ #include "private.h"
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Smart::CBOR & Smart::CBOR::getInstance() {
+		static thread_local CBOR instance;
+		instance.clear();
+		return instance;
+	}
+
+	void Smart::CBOR::head(uint8_t major, uint64_t value) {
+
+		major <<= 5;
+
+		if(value < 24) {
+			buffer.push_back(major | (uint8_t) value);
+			return;
+		}
+
+		size_t length;
+		if(value <= 0xFF) {
+			buffer.push_back(major | 24);
+			length = 1;
+		} else if(value <= 0xFFFF) {
+			buffer.push_back(major | 25);
+			length = 2;
+		} else if(value <= 0xFFFFFFFF) {
+			buffer.push_back(major | 26);
+			length = 4;
+		} else {
+			buffer.push_back(major | 27);
+			length = 8;
+		}
+
+		// Network byte order.
+		while(length--) {
+			buffer.push_back((uint8_t) (value >> (length * 8)));
+		}
+
+	}
+
+	Smart::CBOR & Smart::CBOR::map(ssize_t items) {
+		if(items < 0) {
+			buffer.push_back(0xBF);
+		} else {
+			head(5,(uint64_t) items);
+		}
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::array(ssize_t items) {
+		if(items < 0) {
+			buffer.push_back(0x9F);
+		} else {
+			head(4,(uint64_t) items);
+		}
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::end() {
+		buffer.push_back(0xFF);
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::integer(uint64_t value) {
+		head(0,value);
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::text(const char *value) {
+		size_t length = (value ? strlen(value) : 0);
+		head(3,length);
+		buffer.insert(buffer.end(),(const uint8_t *) value,((const uint8_t *) value) + length);
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::text(const std::string &value) {
+		head(3,value.size());
+		buffer.insert(buffer.end(),value.begin(),value.end());
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::boolean(bool value) {
+		buffer.push_back(value ? 0xF5 : 0xF4);
+		return *this;
+	}
+
+	Smart::CBOR & Smart::CBOR::real(float value) {
+
+		// Single precision float.
+		uint32_t bits;
+		memcpy(&bits,&value,sizeof(bits));
+
+		buffer.push_back(0xFA);
+		for(int shift = 24; shift >= 0; shift -= 8) {
+			buffer.push_back((uint8_t) (bits >> shift));
+		}
+
+		return *this;
+	}
+
+ }
@@ -0,0 +1,319 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the block device classifier and the unsupported device cache.
+  *
+  * The transport is taken from the sysfs device path (/sys/block/<name> is a link to
+  * /sys/devices/<bus path>/block/<name>).
+  *
+  * Cache file lines are '<probe time> <device id>'.
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/configuration.h>
+ #include <fstream>
+ #include <cstring>
+ #include <climits>
+ #include <fnmatch.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Read integer from sysfs.
+	static int sysfs(const string &name, const char *path, int def = 0) {
+		ifstream in{string{"/sys/block/"} + name + path};
+		int value;
+		if(in >> value) {
+			return value;
+		}
+		return def;
+	}
+
+	Smart::Device::Device(const char *path) {
+
+		const char *ptr = strrchr(path,'/');
+		name = (ptr ? ptr+1 : path);
+
+		id = wwid(name);
+		stable = !id.empty();
+		if(!stable) {
+			id = name;
+		}
+
+		char buffer[PATH_MAX+1];
+		if(realpath((string{"/sys/block/"} + name).c_str(),buffer)) {
+
+			string syspath{buffer};
+
+			if(syspath.find("/devices/virtual/") != string::npos) {
+				transport = Virtual;
+			} else if(syspath.find("/virtio") != string::npos) {
+				transport = Virtio;
+			} else if(syspath.find("/usb") != string::npos) {
+				transport = USB;
+			} else if(syspath.find("/nvme") != string::npos) {
+				transport = NVMe;
+			} else if(syspath.find("/ata") != string::npos) {
+				transport = ATA;
+			} else if(syspath.find("/host") != string::npos) {
+				transport = SCSI;
+			}
+
+		} else {
+
+			// No sysfs entry, use the kernel naming.
+			static const struct {
+				const char *prefix;
+				Transport transport;
+			} names[] = {
+				{ "loop",	Virtual	},
+				{ "zram",	Virtual	},
+				{ "ram",	Virtual	},
+				{ "dm-",	Virtual	},
+				{ "md",		Virtual	},
+				{ "nbd",	Virtual	},
+				{ "vd",		Virtio	},
+				{ "nvme",	NVMe	},
+			};
+
+			for(size_t ix = 0; ix < N_ELEMENTS(names); ix++) {
+				if(!strncmp(name.c_str(),names[ix].prefix,strlen(names[ix].prefix))) {
+					transport = names[ix].transport;
+					break;
+				}
+			}
+
+		}
+
+		rotational = (sysfs(name,"/queue/rotational") == 1);
+		removable = (sysfs(name,"/removable") == 1);
+
+		// SCSI peripheral type 5 is CD/DVD.
+		optical = (sysfs(name,"/device/type",-1) == 5 || !strncmp(name.c_str(),"sr",2));
+
+	}
+
+	const char * Smart::Device::transport_name() const noexcept {
+
+		static const char *names[] = { "unknown", "ata", "scsi", "nvme", "usb", "virtio", "virtual" };
+
+		if(((size_t) transport) < N_ELEMENTS(names)) {
+			return names[transport];
+		}
+
+		return names[0];
+
+	}
+
+	bool Smart::Device::match(const char *filters) const {
+
+		while(*filters) {
+
+			while(*filters == ',' || isspace(*filters)) {
+				filters++;
+			}
+
+			size_t length = strcspn(filters,",");
+			string filter{filters,length};
+			filters += length;
+
+			while(!filter.empty() && isspace(filter.back())) {
+				filter.pop_back();
+			}
+
+			if(filter.empty()) {
+				continue;
+			}
+
+			if(!fnmatch(filter.c_str(),name.c_str(),0)) {
+				return true;
+			}
+
+			const char *value = filter.c_str();
+
+			if(!strcasecmp(value,transport_name())
+					|| (!strcasecmp(value,"virtual") && transport == Virtio)
+					|| (!strcasecmp(value,"rotational") && rotational)
+					|| (!strcasecmp(value,"ssd") && !rotational && transport != Virtual && transport != Virtio)
+					|| (!strcasecmp(value,"removable") && removable)
+					|| (!strcasecmp(value,"optical") && optical)) {
+				return true;
+			}
+
+		}
+
+		return false;
+
+	}
+
+	bool Smart::Device::probe() const {
+
+		if(Unsupported::getInstance().contains(id)) {
+			return false;
+		}
+
+		// Devices already probed on this run (configuration reloads).
+		static mutex guard;
+		static unordered_set<string> supported;
+
+		{
+			lock_guard<mutex> lock(guard);
+			if(supported.count(id)) {
+				return true;
+			}
+		}
+
+		try {
+
+			Smart::Disk disk((string{"/dev/"} + name).c_str());
+			disk.read();
+
+			lock_guard<mutex> lock(guard);
+			supported.insert(id);
+
+		} catch(const system_error &e) {
+
+			switch(e.code().value()) {
+			case ENOTSUP:
+			case ENOTTY:
+			case EINVAL:
+			case ENOSYS:
+				// The device can't do S.M.A.R.T., don't try again.
+				Unsupported::getInstance().warning() << "No S.M.A.R.T. support on '" << name << "': " << e.what() << endl;
+				Unsupported::getInstance().insert(id,stable);
+				return false;
+
+			default:
+				// Could be transient, let the agent retry.
+				break;
+			}
+
+		} catch(...) {
+
+			// Could be transient, let the agent retry.
+
+		}
+
+		return true;
+
+	}
+
+	Smart::Unsupported::Unsupported() : Udjat::Logger("smart") {
+
+		filename = Config::Value<string>("smart","negative-cache","");
+		ttl = (time_t) atol(Config::Value<string>("smart","negative-cache-ttl","604800").c_str());
+
+		if(filename.empty()) {
+			return;
+		}
+
+		ifstream in{filename};
+		time_t now = time(nullptr);
+
+		string line;
+		while(getline(in,line)) {
+
+			char *ptr = nullptr;
+			time_t timestamp = (time_t) strtoll(line.c_str(),&ptr,10);
+
+			if(!ptr || *ptr != ' ' || !ptr[1]) {
+				continue;
+			}
+
+			if(ttl && (timestamp + ttl) < now) {
+				// Expired, probe again.
+				continue;
+			}
+
+			entries.push_back(Entry{string{ptr+1},timestamp,true});
+
+		}
+
+	}
+
+	Smart::Unsupported & Smart::Unsupported::getInstance() {
+		static Unsupported instance;
+		return instance;
+	}
+
+	bool Smart::Unsupported::contains(const std::string &id) {
+
+		lock_guard<mutex> lock(guard);
+
+		for(auto &entry : entries) {
+			if(entry.id == id) {
+				return true;
+			}
+		}
+
+		return false;
+
+	}
+
+	void Smart::Unsupported::insert(const std::string &id, bool persistent) {
+
+		lock_guard<mutex> lock(guard);
+
+		for(auto &entry : entries) {
+			if(entry.id == id) {
+				return;
+			}
+		}
+
+		entries.push_back(Entry{id,time(nullptr),persistent});
+
+		if(persistent) {
+			save();
+		}
+
+	}
+
+	void Smart::Unsupported::save() noexcept {
+
+		if(filename.empty()) {
+			return;
+		}
+
+		string tempname{filename + ".tmp"};
+
+		{
+			ofstream out{tempname,ios::trunc};
+			for(auto &entry : entries) {
+				if(entry.persistent) {
+					out << entry.timestamp << ' ' << entry.id << '\n';
+				}
+			}
+			out.flush();
+
+			if(!out) {
+				error() << "Can't write '" << tempname << "': " << strerror(errno) << endl;
+				return;
+			}
+		}
+
+		if(rename(tempname.c_str(),filename.c_str())) {
+			error() << "Can't write '" << filename << "': " << strerror(errno) << endl;
+		}
+
+	}
+
+ }
@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the compact mode storage (arena and bounded string pool).
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/configuration.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Smart::Arena::Arena(size_t l) : length{l} {
+	}
+
+	void * Smart::Arena::allocate(size_t size, size_t alignment) {
+
+		lock_guard<mutex> lock(guard);
+
+		if(!blocks.empty()) {
+
+			size_t offset = length - available;
+			size_t padding = (alignment - (offset % alignment)) % alignment;
+
+			if(size + padding <= available) {
+				available -= (size + padding);
+				used += size;
+				return blocks.back().get() + offset + padding;
+			}
+
+		}
+
+		reserved += std::max(size,length);
+		used += size;
+
+		if(size > length) {
+
+			// Oversized, gets its own block; the current one stays in use.
+			std::unique_ptr<uint8_t[]> block{new uint8_t[size]};
+			uint8_t *ptr = block.get();
+			blocks.insert(blocks.empty() ? blocks.end() : blocks.end()-1, std::move(block));
+			return ptr;
+
+		}
+
+		// New block, operator new[] is aligned for any fundamental type.
+		blocks.emplace_back(new uint8_t[length]);
+		available = length - size;
+		return blocks.back().get();
+
+	}
+
+	void Smart::Arena::get(size_t &r, size_t &u) {
+		lock_guard<mutex> lock(guard);
+		r = reserved;
+		u = used;
+	}
+
+	Smart::Strings::Strings() {
+		limit = (size_t) atoll(Config::Value<string>("smart","string-pool-size","65536").c_str());
+	}
+
+	Smart::Strings & Smart::Strings::getInstance() {
+		static Strings instance;
+		return instance;
+	}
+
+	const char * Smart::Strings::get(const std::string &str, const char *fallback) {
+
+		lock_guard<mutex> lock(guard);
+
+		auto it = strings.find(str);
+		if(it != strings.end()) {
+			return it->c_str();
+		}
+
+		if(used + str.size() + 1 > limit) {
+			return fallback;
+		}
+
+		used += str.size() + 1;
+		return strings.insert(str).first->c_str();
+
+	}
+
+	size_t Smart::Strings::size() {
+		lock_guard<mutex> lock(guard);
+		return used;
+	}
+
+ }
@@ -21,147 +21,148 @@
  #include <udjat/tools/temperature.h>
  #include <udjat/smart/disk.h>
  #include <udjat/tools/configuration.h>
+ #include <sys/stat.h>
+ #include <fstream>
+ #include <iterator>
 
  using namespace std;
 
  namespace Udjat {
 
-	 Smart::Disk::Disk(const char *name) : d(nullptr) {
+	Smart::Disk::Backend::~Backend() {
+	}
 
-		if(sk_disk_open(name, &d) < 0) {
-			throw system_error(errno, system_category(), string{"Can't open "} + name);
-		}
+	std::string Smart::Disk::Backend::blob() {
+		throw system_error(ENOTSUP, system_category(), "Raw data is not available on this device");
+	}
 
-	 }
+	bool Smart::Disk::Backend::status() {
+		read();
+		fresh = true;
+		return Disk::good(overall());
+	}
 
-	 Smart::Disk::~Disk() {
-		sk_disk_free(d);
-	 }
+	void Smart::Disk::Backend::attributes(Callback UDJAT_UNUSED(call), void UDJAT_UNUSED(*userdata)) {
+	}
 
-	 Smart::Disk & Smart::Disk::read() {
+	Smart::Disk::Disk(const char *name, Priority p) : priority{p} {
 
-		// TODO: Reading SMART data might cause the disk to wake up from sleep. Hence from monitoring daemons make sure to call sk_disk_check_power_mode() to check wether the disk is sleeping and skip the read if so
+		// Opening issues an identify command.
+		RateLimiter::getInstance().acquire(priority);
 
-		if(sk_disk_smart_read_data(d) < 0) {
-			throw system_error(errno, system_category(), "Can't read S.M.A.R.T. data");
-		}
-		return *this;
-	 }
+		struct stat st;
+		if(!::stat(name,&st) && S_ISREG(st.st_mode)) {
 
-	bool Smart::Disk::identify_is_available() {
+			if(st.st_size == 512) {
 
-		SkBool available = 0;
+				// Recorded NVMe log page.
+				backend.reset(new NVMeBackend(name,true));
 
-		if(sk_disk_identify_is_available(d,&available) < 0) {
-			throw system_error(errno, system_category(), "Can't teste if identify is available");
-		}
+			} else {
 
-		return available != 0;
+				// Recorded libatasmart blob.
+				ifstream in{name,ios::binary};
+				string blob{istreambuf_iterator<char>(in),istreambuf_iterator<char>()};
+				if(!in.good() && !in.eof()) {
+					throw system_error(errno, system_category(), string{"Can't read "} + name);
+				}
+				backend.reset(new ATABackend(blob));
 
-	}
-
-	const SkIdentifyParsedData * Smart::Disk::identify() {
-		const SkIdentifyParsedData *ipd;
-		if(sk_disk_identify_parse(d, &ipd) < 0) {
-			throw system_error(errno, system_category(), "Can't parse S.M.A.R.T. identify");
-		}
-		return ipd;
-	}
+			}
 
-	SkSmartOverall Smart::Disk::getOverral() {
+		} else {
 
-		SkSmartOverall overall;
+			const char *ptr = strrchr(name,'/');
+			if(!strncmp((ptr ? ptr+1 : name),"nvme",4)) {
+				backend.reset(new NVMeBackend(name));
+			} else {
+				backend.reset(new ATABackend(name));
+			}
 
-		if (sk_disk_smart_get_overall(d, &overall) < 0) {
-			throw system_error(errno, system_category(), "Can't get S.M.A.R.T. overall state");
 		}
 
-		return overall;
+	}
 
+	Smart::Disk::~Disk() {
 	}
 
-	bool Smart::Disk::is_awake() {
-		SkBool awake = 0;
+	Smart::Disk & Smart::Disk::read() {
 
-		if(sk_disk_check_sleep_mode(d,&awake) < 0) {
-			throw system_error(errno, system_category(), "Can't get disk awake state");
+		if(backend->fresh) {
+			// Already read by status(), don't send the command again.
+			backend->fresh = false;
+			return *this;
 		}
 
-		return awake != 0;
+		RateLimiter::getInstance().acquire(priority);
+		backend->read();
+		return *this;
 
 	}
 
-	uint64_t Smart::Disk::size() {
-
-		uint64_t value;
-
-		if(sk_disk_get_size(d,&value) < 0) {
-			throw system_error(errno, system_category(), "Can't get S.M.A.R.T. disk size");
-		}
+	Smart::Blob Smart::Disk::blob() {
+		return Blob{backend->blob()};
+	}
 
-		return value;
+	bool Smart::Disk::status() {
+		RateLimiter::getInstance().acquire(priority);
+		return backend->status();
+	}
 
+	bool Smart::Disk::identify_is_available() {
+		return backend->identify_is_available();
 	}
 
-	uint64_t Smart::Disk::badsectors() {
+	const SkIdentifyParsedData * Smart::Disk::identify() {
+		return backend->identify();
+	}
 
-		uint64_t value;
+	SkSmartOverall Smart::Disk::getOverral() {
+		return backend->overall();
+	}
 
-		if(sk_disk_smart_get_bad(d,&value) < 0) {
-			throw system_error(errno, system_category(), "Can't get bad sectors");
-		}
+	bool Smart::Disk::is_awake() {
+		RateLimiter::getInstance().acquire(priority);
+		return backend->is_awake();
+	}
 
-		return value;
+	uint64_t Smart::Disk::size() {
+		return backend->size();
+	}
 
+	uint64_t Smart::Disk::badsectors() {
+		return backend->badsectors();
 	}
 
 	uint64_t Smart::Disk::poweron() {
-
-		uint64_t mseconds;
-
-		if(sk_disk_smart_get_power_on(d,&mseconds) < 0) {
-			if(errno == ENOENT) {
-				return 0;
-			}
-			throw system_error(errno, system_category(), "Can't get power on");
-		}
-
-		return mseconds;
-
+		return backend->poweron();
 	}
 
 	uint64_t Smart::Disk::powercicle() {
-
-		uint64_t value;
-
-		if(sk_disk_smart_get_power_cycle(d,&value) < 0) {
-			throw system_error(errno, system_category(), "Can't get power cicle");
-		}
-
-		return value;
-
+		return backend->powercicle();
 	}
 
 	Temperature Smart::Disk::temperature() {
 
-		uint64_t value;
-		if(sk_disk_smart_get_temperature(d,&value) < 0) {
-			if(errno == ENOENT) {
-				return Temperature{};
-			}
-			throw system_error(errno, system_category(), "Can't get temperature");
+		uint64_t value = backend->temperature();
+		if(!value) {
+			return Temperature{};
 		}
 
 		// The smart value is in 'Kelvin'
 		Temperature temperature{((float) value / 1000), Temperature::Kelvin};
 
-		Config::Value<string> unitname("smart","temperature-unit","C");
-
-		temperature.set((Temperature::Unity) ::toupper(unitname[0]));
+		temperature.set(Smart::unity());
 
 		return temperature;
 	}
 
+	Temperature::Unity Smart::unity() {
+		// The configured unit is read only once.
+		static const Temperature::Unity unity = (Temperature::Unity) ::toupper(Config::Value<string>("smart","temperature-unit","C")[0]);
+		return unity;
+	}
+
 	string Smart::Disk::formattedSize() {
 
 		static const struct {
@@ -187,4 +188,3 @@
 	 }
 
  }
-
@@ -0,0 +1,229 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the SSD endurance tracker.
+  *
+  * Host writes are the kernel written sectors (field 7 of /sys/block/<name>/stat, 512 bytes
+  * each), NAND writes come from the vendor attribute 0xF9 when reported.
+  *
+  * <https://www.kernel.org/doc/html/latest/block/stat.html>
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/smart/endurance.h>
+ #include <cstdio>
+ #include <cstring>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Smart::Endurance::Window::reset(time_t s) noexcept {
+		seconds = s;
+		for(Sample &bucket : buckets) {
+			bucket.timestamp = 0;
+		}
+	}
+
+	void Smart::Endurance::Window::push_back(const Sample &sample) noexcept {
+
+		if(!seconds) {
+			return;
+		}
+
+		time_t width = (seconds >= (time_t) BUCKETS ? seconds / BUCKETS : 1);
+		time_t slot = sample.timestamp / width;
+		Sample &bucket = buckets[slot % BUCKETS];
+
+		if(!bucket.timestamp || (bucket.timestamp / width) != slot) {
+			// New slot, keep its first sample.
+			bucket = sample;
+		}
+
+	}
+
+	Smart::Endurance::Value Smart::Endurance::Window::get(const Sample &current) const noexcept {
+
+		Value value;
+
+		if(!seconds || !current.timestamp) {
+			return value;
+		}
+
+		// Oldest sample still inside the window.
+		const Sample *oldest = nullptr;
+		for(const Sample &bucket : buckets) {
+			if(bucket.timestamp && bucket.timestamp < current.timestamp && (current.timestamp - bucket.timestamp) <= seconds) {
+				if(!oldest || bucket.timestamp < oldest->timestamp) {
+					oldest = &bucket;
+				}
+			}
+		}
+
+		if(!oldest) {
+			return value;
+		}
+
+		value.seconds = current.timestamp - oldest->timestamp;
+		double elapsed = (double) value.seconds;
+
+		uint64_t host = current.host - oldest->host;
+		value.write = ((double) host) / elapsed;
+
+		if(host && oldest->nand && current.nand > oldest->nand) {
+			value.waf = (float) (((double) (current.nand - oldest->nand)) / ((double) host));
+		}
+
+		if(oldest->life >= 0 && current.life >= 0 && current.life < oldest->life) {
+			double used = (double) (oldest->life - current.life);
+			value.wear = (float) ((used * 86400) / elapsed);
+			value.remaining = (uint64_t) ((((double) current.life) * elapsed) / used);
+			value.projected = true;
+		}
+
+		return value;
+
+	}
+
+	Smart::Endurance::Endurance(const char *devicename, const char *w, uint64_t u) : unit{u} {
+
+		const char *ptr = strrchr(devicename,'/');
+		filename = string{"/sys/block/"} + (ptr ? ptr+1 : devicename) + "/stat";
+
+		size_t ix = 0;
+		while(w && *w && ix < MAX_WINDOWS) {
+			time_t seconds = (time_t) atol(w);
+			if(seconds > 0) {
+				windows[ix++].reset(seconds);
+			}
+			w = strchr(w,',');
+			if(w) {
+				w++;
+			}
+		}
+
+	}
+
+	/// @brief Get the kernel written sectors counter (field 7 of the sysfs stat file).
+	static uint64_t written_sectors(const std::string &filename, uint64_t def) noexcept {
+
+		uint64_t written = def;
+
+		FILE *in = fopen(filename.c_str(),"r");
+		if(in) {
+			unsigned long long field[7];
+			if(fscanf(in,"%llu %llu %llu %llu %llu %llu %llu",field,field+1,field+2,field+3,field+4,field+5,field+6) == 7) {
+				written = field[6];
+			}
+			fclose(in);
+		}
+
+		return written;
+
+	}
+
+	void Smart::Endurance::rebind(const char *devicename) {
+
+		const char *ptr = strrchr(devicename,'/');
+		filename = string{"/sys/block/"} + (ptr ? ptr+1 : devicename) + "/stat";
+
+		// Other block device, other counter; keep the host writes, restart the delta from here.
+		uint64_t written = written_sectors(filename,0);
+
+		lock_guard<mutex> lock(guard);
+		sectors = written;
+
+	}
+
+	void Smart::Endurance::push_back(time_t timestamp, uint64_t nand, float life, uint64_t poweron) noexcept {
+
+		uint64_t written = written_sectors(filename,sectors);
+
+		lock_guard<mutex> lock(guard);
+
+		if(current.timestamp) {
+			// The kernel counter restarts with the device (reboot, hot plug).
+			current.host += (written >= sectors ? written - sectors : written) * 512;
+		}
+
+		sectors = written;
+
+		current.timestamp = timestamp;
+		current.nand = nand * unit;
+		current.life = (life > 100 ? 100 : life);
+		current.poweron = poweron;
+
+		for(Window &window : windows) {
+			window.push_back(current);
+		}
+
+	}
+
+	Smart::Endurance::Sample Smart::Endurance::get() const noexcept {
+		lock_guard<mutex> lock(guard);
+		return current;
+	}
+
+	bool Smart::Endurance::get(size_t ix, Value &value) const noexcept {
+
+		if(ix >= MAX_WINDOWS || !windows[ix].length()) {
+			return false;
+		}
+
+		lock_guard<mutex> lock(guard);
+		value = windows[ix].get(current);
+		return true;
+
+	}
+
+	bool Smart::Endurance::remaining(uint64_t &seconds) const noexcept {
+
+		lock_guard<mutex> lock(guard);
+
+		if(current.life < 0) {
+			return false;
+		}
+
+		if(current.life <= 0) {
+			// Worn out, nothing left to project.
+			seconds = 0;
+			return true;
+		}
+
+		for(const Window &window : windows) {
+			Value value = window.get(current);
+			if(value.projected) {
+				seconds = value.remaining;
+				return true;
+			}
+		}
+
+		// No wear inside the windows, use the average over the device life.
+		if(current.life < 100 && current.poweron) {
+			seconds = (uint64_t) ((((double) current.life) * ((double) current.poweron)) / (100 - current.life));
+			return true;
+		}
+
+		return false;
+
+	}
+
+ }
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the physical disk enumeration.
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/disk/stat.h>
+ #include <fstream>
+ #include <cctype>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Check for NVMe namespace names (nvme<controller>n<namespace>, without partition).
+	static bool is_nvme_namespace(const char *name) {
+
+		if(strncmp(name,"nvme",4) || !isdigit(name[4])) {
+			return false;
+		}
+
+		const char *ptr = name+4;
+		while(isdigit(*ptr)) {
+			ptr++;
+		}
+
+		if(*(ptr++) != 'n' || !isdigit(*ptr)) {
+			return false;
+		}
+
+		while(isdigit(*ptr)) {
+			ptr++;
+		}
+
+		return *ptr == 0;
+
+	}
+
+	string Smart::wwid(const string &name) {
+
+		for(const char *path : { "/device/wwid", "/wwid" }) {
+
+			ifstream in{string{"/sys/block/"} + name + path};
+			string value;
+
+			if(in && getline(in,value)) {
+
+				while(!value.empty() && isspace(value.back())) {
+					value.pop_back();
+				}
+
+				if(!value.empty()) {
+					return value;
+				}
+
+			}
+
+		}
+
+		return "";
+
+	}
+
+	std::vector<std::vector<std::string>> Smart::Disk::enumerate(bool multipath) {
+
+		struct Device {
+			string wwid;
+			vector<string> paths;
+		};
+
+		vector<Device> devices;
+
+		for(Udjat::Disk::Stat &disk : Udjat::Disk::Stat::get()) {
+
+			if(disk.name.empty()) {
+				continue;
+			}
+
+			// NVMe namespaces (nvme0n1) share the blkext major, their minor is not always 0.
+			if(disk.minor == 0 || is_nvme_namespace(disk.name.c_str())) {
+
+				string id{multipath ? wwid(disk.name) : ""};
+				string path{string{"/dev/"} + disk.name};
+
+				bool found = false;
+				if(!id.empty()) {
+					for(Device &device : devices) {
+						if(device.wwid == id) {
+							device.paths.push_back(path);
+							found = true;
+							break;
+						}
+					}
+				}
+
+				if(!found) {
+					devices.push_back(Device{id,{path}});
+				}
+
+			}
+
+		}
+
+		std::vector<std::vector<std::string>> paths;
+		for(Device &device : devices) {
+			paths.push_back(device.paths);
+		}
+
+		return paths;
+
+	}
+
+ }
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the state change journal.
+  *
+  * Clients long-poll with '?since=<sequence>', getting only the transitions
+  * after the sequence number they've already seen; 'resync' is set when the
+  * requested events were already dropped from the journal.
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/request.h>
+ #include <udjat/tools/configuration.h>
+ #include <cerrno>
+ #include <cstdlib>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Smart::Events::Events() {
+
+		size_t size = (size_t) atoi(Config::Value<string>("smart","event-journal","256").c_str());
+		events.resize(size ? size : 1);
+
+		maxwait = (unsigned int) atoi(Config::Value<string>("smart","event-max-wait","30").c_str());
+
+	}
+
+	Smart::Events & Smart::Events::getInstance() {
+		static Events instance;
+		return instance;
+	}
+
+	void Smart::Events::push_back(const char *agent, const char *field, const std::string &value) {
+
+		{
+			lock_guard<mutex> lock(guard);
+
+			Event &event = events[sequence % events.size()];
+
+			event.sequence = ++sequence;
+			event.timestamp = time(nullptr);
+			event.agent = agent;
+			event.field = field;
+			event.value = value;
+		}
+
+		cond.notify_all();
+
+	}
+
+	void Smart::Events::get(uint64_t since, unsigned int wait, Udjat::Response &response, const char *agent) {
+
+		if(wait > maxwait) {
+			wait = maxwait;
+		}
+
+		unique_lock<mutex> lock(guard);
+
+		if(since >= sequence && wait) {
+			cond.wait_for(lock,chrono::seconds(wait),[this,since]{ return sequence > since; });
+		}
+
+		// Oldest sequence still on the journal.
+		uint64_t first = (sequence > events.size() ? sequence - events.size() + 1 : 1);
+
+		response["sequence"] = sequence;
+		response["resync"] = (since + 1 < first || since > sequence);
+
+		Udjat::Value &values = response["events"];
+
+		for(uint64_t seq = std::max(since + 1, first); seq <= sequence; seq++) {
+
+			const Event &event = events[(seq-1) % events.size()];
+
+			if(agent && strcmp(agent,event.agent)) {
+				continue;
+			}
+
+			Udjat::Value &value = values.append();
+			value["sequence"] = event.sequence;
+			value["timestamp"] = (unsigned long) event.timestamp;
+			value["agent"] = event.agent;
+			value["field"] = event.field;
+			value["value"] = event.value;
+
+		}
+
+	}
+
+	bool Smart::Events::get(const Udjat::Request &request, Udjat::Response &response, const char *agent) {
+
+		string since = query(request,"since");
+		if(since.empty()) {
+			return false;
+		}
+
+		char *end = nullptr;
+		errno = 0;
+		unsigned long long sequence = strtoull(since.c_str(),&end,10);
+
+		if(errno || !end || *end || since[0] == '-') {
+			// Malformed sequence, report it on the response.
+			response["error"] = "Invalid 'since' parameter";
+			return true;
+		}
+
+		get(
+			(uint64_t) sequence,
+			(unsigned int) atoi(query(request,"wait").c_str()),
+			response,
+			agent
+		);
+
+		return true;
+
+	}
+
+ }
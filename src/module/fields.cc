@@ -0,0 +1,119 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the response field selector.
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/request.h>
+ #include <strings.h>
+
+ namespace Udjat {
+
+	string Smart::query(const Udjat::Request &request, const char *name) {
+
+		const char *ptr = strchr(request.getPath(),'?');
+		if(!ptr) {
+			return "";
+		}
+
+		size_t szname = strlen(name);
+
+		while(ptr && *ptr) {
+
+			ptr++;
+
+			if(!strncmp(ptr,name,szname) && ptr[szname] == '=') {
+				ptr += (szname+1);
+				const char *end = strchr(ptr,'&');
+				return end ? string{ptr,(size_t) (end-ptr)} : string{ptr};
+			}
+
+			ptr = strchr(ptr,'&');
+		}
+
+		return "";
+
+	}
+
+	uint16_t Smart::fields(const Udjat::Request &request) {
+
+		string selector = query(request,"fields");
+
+		if(selector.empty()) {
+			// The raw data is large, export it only when requested.
+			return FIELD_ALL & ~FIELD_BLOB;
+		}
+
+		static const struct {
+			const char *name;
+			uint16_t field;
+		} names[] = {
+			{ "state",			FIELD_STATE			},
+			{ "temperature",	FIELD_TEMPERATURE	},
+			{ "size",			FIELD_SIZE			},
+			{ "identify",		FIELD_IDENTIFY		},
+			{ "serial",			FIELD_IDENTIFY		},
+			{ "firmware",		FIELD_IDENTIFY		},
+			{ "model",			FIELD_IDENTIFY		},
+			{ "badsectors",		FIELD_BADSECTORS	},
+			{ "poweron",		FIELD_POWERON		},
+			{ "powercicle",		FIELD_POWERCICLE	},
+			{ "read",			FIELD_IOSTATS		},
+			{ "write",			FIELD_IOSTATS		},
+			{ "iostats",		FIELD_IOSTATS		},
+			{ "attribute",		FIELD_ATTRIBUTE		},
+			{ "forecast",		FIELD_FORECAST		},
+			{ "deferred",		FIELD_DEFERRED		},
+			{ "thermal",		FIELD_THERMAL		},
+			{ "paths",			FIELD_PATHS			},
+			{ "memory",			FIELD_MEMORY		},
+			{ "blob",			FIELD_BLOB			},
+			{ "endurance",		FIELD_ENDURANCE		},
+			{ "all",			FIELD_ALL			},
+		};
+
+		uint16_t fields = FIELD_STATE;
+
+		const char *ptr = selector.c_str();
+		while(*ptr) {
+
+			const char *end = strchr(ptr,',');
+			size_t length = (end ? (size_t) (end-ptr) : strlen(ptr));
+
+			for(size_t ix = 0; ix < N_ELEMENTS(names); ix++) {
+				if(strlen(names[ix].name) == length && !strncasecmp(ptr,names[ix].name,length)) {
+					fields |= names[ix].field;
+					break;
+				}
+			}
+
+			ptr += length;
+			if(*ptr) {
+				ptr++;
+			}
+		}
+
+		return fields;
+
+	}
+
+ }
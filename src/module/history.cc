@@ -0,0 +1,509 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the S.M.A.R.T. history store.
+  *
+  * Segment files ([history-path]/[hostname].[segment].smh) are sequences of blocks:
+  *
+  *	"SMH1" uint32le(length) payload
+  *
+  * Payload is varint(name length) name varint(count) varint(attributes) attribute-ids
+  * followed by one column per field (timestamp, value, temperature, badsectors,
+  * poweron, powercicle, attributes...), each with 'count' zigzag varint deltas.
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/configuration.h>
+ #include <udjat/tools/logger.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <dirent.h>
+ #include <sys/stat.h>
+ #include <sys/mman.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	static const uint8_t magic[] = { 'S', 'M', 'H', '1' };
+
+	/// @brief Number of fixed columns (timestamp, value, temperature, badsectors, poweron, powercicle).
+	static constexpr size_t FIXED_COLUMNS = 6;
+
+	static void put_varint(string &block, uint64_t value) {
+		while(value >= 0x80) {
+			block += (char) ((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		block += (char) value;
+	}
+
+	static bool get_varint(const uint8_t *&ptr, const uint8_t *end, uint64_t &value) {
+		value = 0;
+		for(unsigned int shift = 0; ptr < end && shift < 64; shift += 7) {
+			uint8_t byte = *(ptr++);
+			value |= ((uint64_t) (byte & 0x7F)) << shift;
+			if(!(byte & 0x80)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static inline uint64_t zigzag(int64_t value) {
+		return (((uint64_t) value) << 1) ^ (uint64_t) (value >> 63);
+	}
+
+	static inline int64_t unzigzag(uint64_t value) {
+		return (int64_t) (value >> 1) ^ -((int64_t) (value & 1));
+	}
+
+	/// @brief Get column value from sample.
+	static uint64_t column(const Smart::History::Sample &sample, size_t col, const uint8_t *ids) {
+
+		switch(col) {
+		case 0:
+			return sample.timestamp;
+		case 1:
+			return sample.value;
+		case 2:
+			return sample.temperature;
+		case 3:
+			return sample.badsectors;
+		case 4:
+			return sample.poweron;
+		case 5:
+			return sample.powercicle;
+		}
+
+		uint8_t id = ids[col-FIXED_COLUMNS];
+		for(size_t ix = 0; ix < sample.attributes; ix++) {
+			if(sample.attribute[ix].id == id) {
+				return sample.attribute[ix].raw;
+			}
+		}
+
+		return 0;
+	}
+
+	Smart::History::History() : Udjat::Logger("smart") {
+
+		path = Config::Value<string>("smart","history-path","");
+		segment_size = (size_t) atol(Config::Value<string>("smart","history-segment-size","4194304").c_str());
+		segments = (size_t) atol(Config::Value<string>("smart","history-segments","16").c_str());
+		batch = (size_t) atol(Config::Value<string>("smart","history-batch","16").c_str());
+
+		if(segments < 2) {
+			segments = 2;
+		}
+
+		if(!batch) {
+			batch = 1;
+		}
+
+		if(path.empty()) {
+			return;
+		}
+
+		char hostname[256];
+		if(gethostname(hostname,sizeof(hostname)-1)) {
+			strcpy(hostname,"localhost");
+		}
+		hostname[sizeof(hostname)-1] = 0;
+		prefix = hostname;
+
+		// Find the last segment.
+		DIR *dir = opendir(path.c_str());
+		if(!dir) {
+			error() << "Can't open history path '" << path << "': " << strerror(errno) << endl;
+			path.clear();
+			return;
+		}
+
+		struct dirent *entry;
+		while((entry = readdir(dir)) != NULL) {
+			unsigned int segment;
+			char suffix[5];
+			if(!strncmp(entry->d_name,(prefix + ".").c_str(),prefix.size()+1)
+					&& sscanf(entry->d_name + prefix.size() + 1,"%08u.%4s",&segment,suffix) == 2
+					&& !strcmp(suffix,"smh")
+					&& segment > current) {
+				current = segment;
+			}
+		}
+		closedir(dir);
+
+	}
+
+	Smart::History::~History() {
+		lock_guard<mutex> lock(guard);
+		for(Series &s : series) {
+			flush(s);
+		}
+	}
+
+	Smart::History & Smart::History::getInstance() {
+		static History instance;
+		return instance;
+	}
+
+	string Smart::History::filename(unsigned int segment) const {
+		char name[20];
+		snprintf(name,sizeof(name),".%08u.smh",segment);
+		return path + "/" + prefix + name;
+	}
+
+	void Smart::History::push_back(const char *name, const Sample &sample) {
+
+		if(!enabled()) {
+			return;
+		}
+
+		lock_guard<mutex> lock(guard);
+
+		for(Series &s : series) {
+			if(!strcmp(s.name,name)) {
+				s.samples.push_back(sample);
+				if(s.samples.size() >= batch) {
+					flush(s);
+				}
+				return;
+			}
+		}
+
+		series.push_back(Series{name,{}});
+		series.back().samples.reserve(batch);
+		series.back().samples.push_back(sample);
+
+	}
+
+	void Smart::History::flush(Series &s) {
+
+		if(s.samples.empty()) {
+			return;
+		}
+
+		// Attribute columns, in order of appearance.
+		uint8_t ids[MAX_ATTRIBUTES];
+		size_t attributes = 0;
+
+		for(const Sample &sample : s.samples) {
+			for(size_t ix = 0; ix < sample.attributes; ix++) {
+				if(!memchr(ids,sample.attribute[ix].id,attributes) && attributes < MAX_ATTRIBUTES) {
+					ids[attributes++] = sample.attribute[ix].id;
+				}
+			}
+		}
+
+		string payload;
+		payload.reserve(64 + (s.samples.size() * (FIXED_COLUMNS + attributes) * 2));
+
+		size_t szname = strlen(s.name);
+		put_varint(payload,szname);
+		payload.append(s.name,szname);
+		put_varint(payload,s.samples.size());
+		put_varint(payload,attributes);
+		payload.append((const char *) ids,attributes);
+
+		for(size_t col = 0; col < FIXED_COLUMNS + attributes; col++) {
+			uint64_t previous = 0;
+			for(const Sample &sample : s.samples) {
+				uint64_t value = column(sample,col,ids);
+				put_varint(payload,zigzag((int64_t) (value - previous)));
+				previous = value;
+			}
+		}
+
+		s.samples.clear();
+
+		string block{(const char *) magic,sizeof(magic)};
+		uint32_t length = (uint32_t) payload.size();
+		for(size_t ix = 0; ix < 4; ix++) {
+			block += (char) ((length >> (ix * 8)) & 0xFF);
+		}
+		block += payload;
+
+		string name{filename(current)};
+
+		int fd = open(name.c_str(),O_WRONLY|O_APPEND|O_CREAT,0640);
+		if(fd < 0) {
+			error() << "Can't open '" << name << "': " << strerror(errno) << endl;
+			return;
+		}
+
+		if(write(fd,block.data(),block.size()) != (ssize_t) block.size()) {
+			error() << "Can't write '" << name << "': " << strerror(errno) << endl;
+		}
+
+		struct stat st;
+		if(!fstat(fd,&st) && ((size_t) st.st_size) >= segment_size) {
+
+			// Rotate, remove the oldest segment.
+			current++;
+			if(current >= segments) {
+				unlink(filename(current - segments).c_str());
+			}
+
+		}
+
+		close(fd);
+
+	}
+
+	bool Smart::History::range(const uint8_t *data, size_t length, Range &range) {
+
+		bool found = false;
+		const uint8_t *ptr = data;
+		const uint8_t *end = data + length;
+
+		while(ptr + 8 <= end && !memcmp(ptr,magic,sizeof(magic))) {
+
+			uint32_t payload = ptr[4] | (ptr[5] << 8) | (ptr[6] << 16) | (((uint32_t) ptr[7]) << 24);
+			const uint8_t *block = ptr + 8;
+			const uint8_t *next = block + payload;
+
+			if(next > end) {
+				break;
+			}
+
+			ptr = next;
+
+			// Skip the name and the attribute ids, the timestamps are the first column.
+			uint64_t len, count, attributes;
+			if(!get_varint(block,next,len) || block + len > next) {
+				continue;
+			}
+			block += len;
+
+			if(!get_varint(block,next,count) || count > payload || !get_varint(block,next,attributes) || block + attributes > next) {
+				continue;
+			}
+			block += attributes;
+
+			uint64_t timestamp = 0;
+			for(uint64_t ix = 0; ix < count; ix++) {
+
+				uint64_t delta;
+				if(!get_varint(block,next,delta)) {
+					break;
+				}
+
+				timestamp += (uint64_t) unzigzag(delta);
+
+				if(!found || timestamp < range.from) {
+					range.from = timestamp;
+				}
+
+				if(!found || timestamp > range.to) {
+					range.to = timestamp;
+				}
+
+				found = true;
+
+			}
+
+		}
+
+		return found;
+
+	}
+
+	void Smart::History::decode(const uint8_t *data, size_t length, const char *name, uint64_t from, uint64_t to, const std::function<void(const Sample &)> &call) {
+
+		size_t szname = strlen(name);
+		const uint8_t *ptr = data;
+		const uint8_t *end = data + length;
+
+		while(ptr + 8 <= end && !memcmp(ptr,magic,sizeof(magic))) {
+
+			uint32_t payload = ptr[4] | (ptr[5] << 8) | (ptr[6] << 16) | (((uint32_t) ptr[7]) << 24);
+			const uint8_t *block = ptr + 8;
+			const uint8_t *next = block + payload;
+
+			if(next > end) {
+				// Truncated block (interrupted write).
+				return;
+			}
+
+			ptr = next;
+
+			uint64_t len, count, attributes;
+			if(!get_varint(block,next,len) || len != szname || block + len > next || memcmp(block,name,szname)) {
+				continue;
+			}
+			block += len;
+
+			if(!get_varint(block,next,count) || count > payload || !get_varint(block,next,attributes) || attributes > MAX_ATTRIBUTES || block + attributes > next) {
+				continue;
+			}
+
+			const uint8_t *ids = block;
+			block += attributes;
+
+			// Every value takes at least one byte, reject counts the payload can't hold.
+			if(count * (FIXED_COLUMNS + attributes) > (uint64_t) (next - block)) {
+				continue;
+			}
+
+			vector<Sample> samples(count);
+			for(size_t ix = 0; ix < count; ix++) {
+				samples[ix].attributes = attributes;
+				for(size_t a = 0; a < attributes; a++) {
+					samples[ix].attribute[a].id = ids[a];
+				}
+			}
+
+			bool valid = true;
+			for(size_t col = 0; valid && col < FIXED_COLUMNS + attributes; col++) {
+
+				uint64_t value = 0;
+
+				for(Sample &sample : samples) {
+
+					uint64_t delta;
+					if(!get_varint(block,next,delta)) {
+						valid = false;
+						break;
+					}
+
+					value += (uint64_t) unzigzag(delta);
+
+					switch(col) {
+					case 0:
+						sample.timestamp = value;
+						break;
+					case 1:
+						sample.value = value;
+						break;
+					case 2:
+						sample.temperature = value;
+						break;
+					case 3:
+						sample.badsectors = value;
+						break;
+					case 4:
+						sample.poweron = value;
+						break;
+					case 5:
+						sample.powercicle = value;
+						break;
+					default:
+						sample.attribute[col-FIXED_COLUMNS].raw = value;
+					}
+
+				}
+
+			}
+
+			if(!valid) {
+				continue;
+			}
+
+			for(const Sample &sample : samples) {
+				if(sample.timestamp >= from && sample.timestamp <= to) {
+					call(sample);
+				}
+			}
+
+		}
+
+	}
+
+	void Smart::History::get(const char *name, uint64_t from, uint64_t to, const std::function<void(const Sample &)> &call) {
+
+		if(!enabled()) {
+			return;
+		}
+
+		// Copy the state under the lock, decode without it (don't block the refresh threads).
+		unsigned int first, last;
+		std::map<unsigned int,Range> ranges;
+		std::vector<Sample> pending;
+
+		{
+			lock_guard<mutex> lock(guard);
+
+			first = (current >= segments ? current - segments + 1 : 0);
+			last = current;
+
+			// Forget the removed segments.
+			index.erase(index.begin(),index.lower_bound(first));
+			ranges = index;
+
+			for(const Series &s : series) {
+				if(!strcmp(s.name,name)) {
+					pending = s.samples;
+				}
+			}
+		}
+
+		for(unsigned int segment = first; segment <= last; segment++) {
+
+			auto it = ranges.find(segment);
+			if(it != ranges.end() && (it->second.to < from || it->second.from > to)) {
+				// Closed segment outside the range.
+				continue;
+			}
+
+			int fd = open(filename(segment).c_str(),O_RDONLY);
+			if(fd < 0) {
+				continue;
+			}
+
+			struct stat st;
+			if(!fstat(fd,&st) && st.st_size > 0) {
+
+				void *data = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+				if(data != MAP_FAILED) {
+
+					Range range;
+					bool indexed = (it == ranges.end() && segment < last && History::range((const uint8_t *) data,(size_t) st.st_size,range));
+
+					if(indexed) {
+						// Closed segment, it doesn't change anymore.
+						lock_guard<mutex> lock(guard);
+						index[segment] = range;
+					}
+
+					if(!indexed || !(range.to < from || range.from > to)) {
+						decode((const uint8_t *) data,(size_t) st.st_size,name,from,to,call);
+					}
+
+					munmap(data,st.st_size);
+
+				}
+
+			}
+
+			close(fd);
+
+		}
+
+		// Samples not written yet.
+		for(const Sample &sample : pending) {
+			if(sample.timestamp >= from && sample.timestamp <= to) {
+				call(sample);
+			}
+		}
+
+	}
+
+ }
@@ -24,6 +24,7 @@
  #include <udjat/tools/disk/stat.h>
  #include <unistd.h>
  #include <fstream>
+ #include <map>
  #include "private.h"
 
  using namespace std;
@@ -45,8 +46,8 @@
 
 		if(*devname) {
 
-			// Has device name, create a device node.
-			return  make_shared<Smart::Agent>(devname,node);
+			// Has device name, create a device node (or reuse it, if the definition didn't change).
+			return Smart::Registry::getInstance().get(vector<string>{devname},node);
 
 		}
 
@@ -54,6 +55,20 @@
 
 		/// @brief Container with detected physical disks.
 		class PhysicalDisks : public Abstract::Agent {
+		private:
+
+			/// @brief Agent storage in compact mode (nullptr if disabled).
+			std::shared_ptr<Smart::Arena> arena;
+
+			/// @brief The disk agents (they're not direct children when grouped by topology).
+			std::vector<std::shared_ptr<Smart::Agent>> agents;
+
+			/// @brief The RAID array agents.
+			std::vector<std::shared_ptr<Smart::ArrayAgent>> arrays;
+
+			/// @brief Devices not monitored, and why.
+			std::vector<std::pair<std::string,const char *>> skipped;
+
 		public:
 			PhysicalDisks(const pugi::xml_node &node) : Abstract::Agent("storage") {
 
@@ -62,12 +77,122 @@
 
 				load(node);
 
-				// Load disks
-				for(Disk::Stat &disk : Disk::Stat::get()) {
+				auto disks = Smart::Disk::enumerate(Attribute(node,"multipath",true).as_bool(true));
+
+				if(Attribute(node,"compact",true).as_bool(false)) {
+					// Compact mode, all agents (and their control blocks) on the same storage.
+					arena = make_shared<Smart::Arena>((disks.empty() ? 1 : disks.size()) * (sizeof(Smart::Agent) + 64));
+				}
+
+				// Group by host adapter and enclosure?
+				bool topology = Attribute(node,"topology",true).as_bool(false);
+				std::map<std::string,std::shared_ptr<Smart::Group>> groups;
+
+				// Disk agents by kernel name, for the RAID membership.
+				std::map<std::string,std::shared_ptr<Smart::Agent>> names;
+
+				// Container attributes, changing them doesn't rebuild the disk agents ('topology'
+				// and 'raid' are not here, they attach the agents to host adapters and arrays).
+				static const char *container_only[] = {
+					"multipath",
+					"include",
+					"exclude",
+					"correlated-failures",
+					"correlated-window",
+					nullptr
+				};
+
+				// Device filters, by name pattern or class ('sd*,usb,...').
+				const char *include = Attribute(node,"include",true).as_string("");
+				const char *exclude = Attribute(node,"exclude",true).as_string("virtual,optical");
+
+				// Load disks, grouping the paths to the same physical device; unchanged ones are
+				// reused from the previous configuration.
+				for(auto &paths : disks) {
+
+					Smart::Device device{paths[0].c_str()};
+
+					if(!device.allowed(include,exclude)) {
+						skipped.emplace_back(device.name,"filtered");
+						continue;
+					}
+
+					if(!device.probe()) {
+						skipped.emplace_back(device.name,"unsupported");
+						continue;
+					}
+
+					auto agent = Smart::Registry::getInstance().get(paths,node,arena,container_only);
+					agents.push_back(agent);
+
+					for(auto &path : paths) {
+						names[path.substr(path.rfind('/')+1)] = agent;
+					}
 
-					if(disk.minor == 0 && !disk.name.empty()) {
-						std::shared_ptr<Udjat::Abstract::Agent> agent = make_shared<Smart::Agent>((string{"/dev/"} + disk.name).c_str(),node);
+					if(!topology) {
 						Udjat::Abstract::Agent::push_back(agent);
+						continue;
+					}
+
+					// Group by host adapter and enclosure.
+					Smart::Location location{device.name};
+
+					string id{location.controller.empty() ? "other" : location.controller};
+
+					auto &controller = groups[id];
+					if(!controller) {
+						controller = make_shared<Smart::Group>(id,string{"Host adapter "} + id,"drive-multidisk");
+						controller->controller = make_shared<Smart::Controller>(
+														id,
+														Attribute(node,"correlated-failures",true).as_uint(50),
+														(time_t) Attribute(node,"correlated-window",true).as_uint(120)
+													);
+						Udjat::Abstract::Agent::push_back(controller);
+					}
+
+					controller->controller->add();
+					controller->add(agent,location.slot);
+					agent->attach(controller->controller);
+					agent->attach(controller);
+
+					if(location.enclosure.empty()) {
+						controller->push_back(agent);
+						continue;
+					}
+
+					auto &enclosure = groups[id + "/" + location.enclosure];
+					if(!enclosure) {
+						enclosure = make_shared<Smart::Group>(location.enclosure,string{"Enclosure "} + location.enclosure,"drive-multidisk");
+						controller->push_back(enclosure);
+					}
+
+					enclosure->add(agent,location.slot);
+					agent->attach(enclosure);
+					enclosure->push_back(agent);
+
+				}
+
+				if(Attribute(node,"raid",true).as_bool(true)) {
+
+					// RAID arrays with monitored members, one risk agent for each.
+					for(auto array : Smart::Array::enumerate()) {
+
+						auto agent = make_shared<Smart::ArrayAgent>(array);
+
+						for(auto &member : array->members) {
+							auto it = names.find(member);
+							if(it != names.end()) {
+								it->second->attach(array);
+								it->second->attach(agent);
+								agent->add(it->second);
+							}
+						}
+
+						if(!agent->empty()) {
+							arrays.push_back(agent);
+							Udjat::Abstract::Agent::push_back(agent);
+						}
+
 					}
 
 				}
@@ -80,22 +205,75 @@
 			/// @brief Export device info.
 			void get(const Udjat::Request &request, Udjat::Response &response) override {
 
+				if(Smart::Events::getInstance().get(request,response)) {
+					// Event request ('?since=<sequence>'), export only the changes.
+					return;
+				}
+
+				if(Smart::query(request,"format") == "cbor") {
+
+					// Binary response, from the agents' cached values.
+					Smart::CBOR &cbor = Smart::CBOR::getInstance();
+
+					cbor.map(3);
+					cbor.integer(Smart::CBOR::ENVELOPE_SCHEMA,Smart::CBOR::SCHEMA);
+					cbor.integer(Smart::CBOR::ENVELOPE_TIMESTAMP,time(nullptr));
+					cbor.integer(Smart::CBOR::ENVELOPE_DISKS).array(agents.size());
+
+					for(auto agent : agents) {
+						agent->encode(cbor);
+					}
+
+					static thread_local string payload;
+					Smart::base64(cbor.data(),cbor.size(),payload);
+
+					response["schema"] = Smart::CBOR::SCHEMA;
+					response["cbor"] = payload;
+					return;
+
+				}
+
 				Abstract::Agent::get(request,response);
 
-				Udjat::Value &devices = response["devices"];
+				if(Smart::RateLimiter::getInstance().enabled()) {
 
-				for(auto child : *this) {
+					auto counters = Smart::RateLimiter::getInstance().get();
 
-					auto agent = dynamic_cast<Smart::Agent *>(child.get());
-					if(!agent)
-						continue;
+					Udjat::Value &limiter = response["ratelimit"];
+					limiter["granted"] = counters.granted;
+					limiter["throttled-refresh"] = counters.throttled[Smart::Disk::Refresh];
+					limiter["throttled-request"] = counters.throttled[Smart::Disk::Request];
+					limiter["rejected"] = counters.rejected;
+
+				}
+
+				if(arena) {
+
+					size_t reserved, used;
+					arena->get(reserved,used);
+
+					Udjat::Value &memory = response["memory"];
+					memory["arena-reserved"] = reserved;
+					memory["arena-used"] = used;
+					memory["strings"] = Smart::Strings::getInstance().size();
+
+				}
 
-					// It's an smart agent ...
+				if(!skipped.empty()) {
+					Udjat::Value &values = response["skipped"];
+					for(auto &entry : skipped) {
+						Udjat::Value &value = values.append();
+						value["name"] = entry.first;
+						value["reason"] = entry.second;
+					}
+				}
+
+				Udjat::Value &devices = response["devices"];
 
-					// ... Refresh agent data ...
-					agent->Abstract::Agent::refresh(true);
+				for(auto agent : agents) {
 
-					// ... and export it.
+					// Serve the cached state, the agent timers keep it updated;
+					// refreshing here would poll every disk at refresh priority.
 					Udjat::Value &device = devices.append();
 
 					device["name"] = agent->name();
@@ -105,6 +283,23 @@
 
 				}
 
+				if(!arrays.empty()) {
+
+					Udjat::Value &values = response["arrays"];
+
+					for(auto array : arrays) {
+
+						// After the disks, the risk depends on their states.
+						array->refresh();
+
+						Udjat::Value &value = values.append();
+						value["name"] = array->name();
+						value["state"] = array->state()->summary();
+
+					}
+
+				}
+
 			}
 
 		};
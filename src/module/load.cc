@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the block device load sampler.
+  *
+  * <https://www.kernel.org/doc/html/latest/block/stat.html>
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/smart/load.h>
+ #include <cstdio>
+ #include <ctime>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Smart::Load::Load(const char *devicename) {
+
+		const char *ptr = strrchr(devicename,'/');
+		filename = string{"/sys/block/"} + (ptr ? ptr+1 : devicename) + "/stat";
+
+		sample();
+
+	}
+
+	void Smart::Load::rebind(const char *devicename) {
+
+		const char *ptr = strrchr(devicename,'/');
+		filename = string{"/sys/block/"} + (ptr ? ptr+1 : devicename) + "/stat";
+
+		// The counters are from another block device, restart.
+		last = {};
+		sample();
+
+	}
+
+	Smart::Load::Value Smart::Load::sample() noexcept {
+
+		Value value;
+
+		FILE *in = fopen(filename.c_str(),"r");
+		if(!in) {
+			return value;
+		}
+
+		unsigned long long field[11];
+		int fields = fscanf(in,"%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+						field,field+1,field+2,field+3,field+4,field+5,field+6,field+7,field+8,field+9,field+10);
+		fclose(in);
+
+		if(fields != 11) {
+			return value;
+		}
+
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC,&ts);
+		uint64_t timestamp = (((uint64_t) ts.tv_sec) * 1000) + (ts.tv_nsec / 1000000);
+
+		// Field 10 is io_ticks, field 11 is time_in_queue, both in ms.
+		if(last.timestamp && timestamp > last.timestamp && field[9] >= last.ticks && field[10] >= last.queue) {
+			float elapsed = (float) (timestamp - last.timestamp);
+			value.utilization = ((float) (field[9] - last.ticks) * 100) / elapsed;
+			value.inflight = ((float) (field[10] - last.queue)) / elapsed;
+			if(value.utilization > 100) {
+				value.utilization = 100;
+			}
+		}
+
+		// Fields 1 and 5 are completed reads and writes, fields 4 and 8 the time spent on them.
+		uint64_t ios = field[0] + field[4];
+		uint64_t wait = field[3] + field[7];
+
+		if(last.timestamp && ios > last.ios && wait >= last.wait) {
+			value.latency = ((float) (wait - last.wait)) / ((float) (ios - last.ios));
+		}
+
+		last.ios = ios;
+		last.wait = wait;
+		last.timestamp = timestamp;
+		last.ticks = field[9];
+		last.queue = field[10];
+
+		return value;
+
+	}
+
+ }
@@ -0,0 +1,259 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the NVMe backend.
+  *
+  * Reads the SMART/Health Information log page (log identifier 02h) using the
+  * admin passthrough ioctl and maps it onto the libatasmart model.
+  *
+  * <https://nvmexpress.org/wp-content/uploads/NVM-Express-1_4-2019.06.10-Ratified.pdf>
+  *
+  */
+
+ #include "private.h"
+ #include <sys/ioctl.h>
+ #include <sys/stat.h>
+ #include <linux/nvme_ioctl.h>
+ #include <linux/fs.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Smart::NVMeBackend::NVMeBackend(const char *n, bool r) : name{n}, recorded{r} {
+
+		memset(log,0,sizeof(log));
+		memset(&ipd,0,sizeof(ipd));
+
+		if(!recorded) {
+			fd = ::open(name.c_str(),O_RDONLY);
+			if(fd < 0) {
+				throw system_error(errno, system_category(), string{"Can't open "} + name);
+			}
+		}
+
+	}
+
+	Smart::NVMeBackend::~NVMeBackend() {
+		if(fd >= 0) {
+			::close(fd);
+		}
+	}
+
+	uint64_t Smart::NVMeBackend::le64(size_t offset) const noexcept {
+		// Counters are little endian; only the lower 64 bits of the 128 bit ones are used.
+		uint64_t value = 0;
+		for(size_t ix = 0; ix < 8; ix++) {
+			value |= ((uint64_t) log[offset+ix]) << (ix * 8);
+		}
+		return value;
+	}
+
+	void Smart::NVMeBackend::admin(uint8_t opcode, uint32_t nsid, uint32_t cdw10, void *data, uint32_t length) {
+
+		struct nvme_admin_cmd cmd;
+		memset(&cmd,0,sizeof(cmd));
+
+		cmd.opcode = opcode;
+		cmd.nsid = nsid;
+		cmd.addr = (uint64_t) (uintptr_t) data;
+		cmd.data_len = length;
+		cmd.cdw10 = cdw10;
+
+		int rc = ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd);
+		if(rc < 0) {
+			throw system_error(errno, system_category(), "NVMe admin command failed");
+		}
+
+		if(rc > 0) {
+			// Positive values are NVMe status codes.
+			throw system_error(EIO, system_category(), "NVMe admin command returned an error status");
+		}
+
+	}
+
+	void Smart::NVMeBackend::read() {
+
+		if(recorded) {
+
+			int f = ::open(name.c_str(),O_RDONLY);
+			if(f < 0) {
+				throw system_error(errno, system_category(), string{"Can't open "} + name);
+			}
+
+			ssize_t bytes = ::read(f,log,sizeof(log));
+			int err = errno;
+			::close(f);
+
+			if(bytes < 0) {
+				throw system_error(err, system_category(), string{"Can't read "} + name);
+			}
+
+			if(bytes != (ssize_t) sizeof(log)) {
+				throw runtime_error(string{"Invalid NVMe log page size in "} + name);
+			}
+
+			return;
+		}
+
+		// Get Log Page, SMART/Health Information, controller scope; NUMDL is 0's based dwords.
+		admin(0x02, 0xFFFFFFFF, 0x02 | (((sizeof(log)/4)-1) << 16), log, sizeof(log));
+
+	}
+
+	bool Smart::NVMeBackend::identify_is_available() {
+		return !recorded;
+	}
+
+	const SkIdentifyParsedData * Smart::NVMeBackend::identify() {
+
+		if(recorded) {
+			throw system_error(ENOTSUP, system_category(), "Identify is not available on recorded log pages");
+		}
+
+		if(!ipd_valid) {
+
+			uint8_t data[4096];
+			memset(data,0,sizeof(data));
+
+			// Identify, CNS 01h (controller data structure).
+			admin(0x06, 0, 0x01, data, sizeof(data));
+
+			// Copy an ASCII field stripping the trailing spaces.
+			auto copy = [data](char *to, size_t offset, size_t length) {
+				memcpy(to,data+offset,length);
+				to[length] = 0;
+				while(length > 0 && (to[length-1] == ' ' || !to[length-1])) {
+					to[--length] = 0;
+				}
+			};
+
+			copy(ipd.serial,4,20);
+			copy(ipd.model,24,40);
+			copy(ipd.firmware,64,8);
+
+			ipd_valid = true;
+		}
+
+		return &ipd;
+	}
+
+	SkSmartOverall Smart::NVMeBackend::overall() {
+
+		uint8_t warning = log[0];
+
+		if(warning & 0x0C) {
+			// Reliability degraded or media in read only mode.
+			return SK_SMART_OVERALL_BAD_STATUS;
+		}
+
+		if(warning & 0x13) {
+			// Spare below threshold, temperature out of range or volatile backup failed.
+			return SK_SMART_OVERALL_BAD_ATTRIBUTE_NOW;
+		}
+
+		if(le64(160)) {
+			// Media and data integrity errors.
+			return SK_SMART_OVERALL_BAD_SECTOR;
+		}
+
+		if(log[5] >= 100) {
+			// Percentage used reached the vendor endurance estimate.
+			return SK_SMART_OVERALL_BAD_ATTRIBUTE_IN_THE_PAST;
+		}
+
+		return SK_SMART_OVERALL_GOOD;
+
+	}
+
+	bool Smart::NVMeBackend::is_awake() {
+		// NVMe power states are handled by the controller, the log page is always available.
+		return true;
+	}
+
+	uint64_t Smart::NVMeBackend::size() {
+
+		if(recorded) {
+			throw system_error(ENOTSUP, system_category(), "Size is not available on recorded log pages");
+		}
+
+		uint64_t value = 0;
+		if(ioctl(fd,BLKGETSIZE64,&value) < 0) {
+			throw system_error(errno, system_category(), "Can't get NVMe disk size");
+		}
+
+		return value;
+
+	}
+
+	uint64_t Smart::NVMeBackend::badsectors() {
+		return le64(160);
+	}
+
+	uint64_t Smart::NVMeBackend::poweron() {
+		return le64(128) * 3600000LL;
+	}
+
+	uint64_t Smart::NVMeBackend::powercicle() {
+		return le64(112);
+	}
+
+	uint64_t Smart::NVMeBackend::temperature() {
+		// Composite temperature, in Kelvin.
+		return ((uint64_t) (log[1] | (log[2] << 8))) * 1000;
+	}
+
+	std::string Smart::NVMeBackend::blob() {
+		return string{(const char *) log,sizeof(log)};
+	}
+
+	void Smart::NVMeBackend::attributes(Callback call, void *userdata) {
+
+		// Map the normalized health values onto the equivalent ATA attributes.
+		SkSmartAttributeParsedData a;
+
+		memset(&a,0,sizeof(a));
+		a.id = 0xE8;
+		a.name = "available-reserved-space";
+		a.pretty_unit = SK_SMART_ATTRIBUTE_UNIT_PERCENT;
+		a.prefailure = a.threshold_valid = a.current_value_valid = 1;
+		a.current_value = a.worst_value = log[3];
+		a.threshold = log[4];
+		a.good_now_valid = 1;
+		a.good_now = (a.current_value >= a.threshold);
+		a.pretty_value = log[3];
+		a.raw[0] = log[3];
+		call(a,userdata);
+
+		memset(&a,0,sizeof(a));
+		a.id = 0xE7;
+		a.name = "ssd-life-left";
+		a.pretty_unit = SK_SMART_ATTRIBUTE_UNIT_PERCENT;
+		a.current_value_valid = 1;
+		a.current_value = a.worst_value = (log[5] >= 100 ? 0 : 100 - log[5]);
+		a.pretty_value = a.current_value;
+		a.raw[0] = log[5];
+		call(a,userdata);
+
+	}
+
+ }
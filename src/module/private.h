@@ -21,8 +21,858 @@
 
  #include <udjat/defs.h>
  #include <udjat/smart/agent.h>
+ #include <udjat/smart/disk.h>
+ #include <udjat/smart/load.h>
+ #include <udjat/tools/logger.h>
+ #include <mutex>
+ #include <condition_variable>
+ #include <chrono>
+ #include <vector>
+ #include <string>
+ #include <functional>
+ #include <map>
+ #include <memory>
+ #include <unordered_set>
 
  using namespace std;
  using namespace Udjat;
 
+ namespace Udjat {
+
+	namespace Smart {
+
+		/// @brief Get the configured temperature unit ('temperature-unit' on the [smart] section).
+		Temperature::Unity unity();
+
+		/// @brief Get query parameter from request path ('?name=value&...').
+		/// @return The parameter value (empty if not found).
+		std::string query(const Udjat::Request &request, const char *name);
+
+		/// @brief Base64 encode (RFC 4648).
+		/// @param data The data to encode.
+		/// @param length The data length.
+		/// @param str The encoded data (replaced, its buffer is reused).
+		void base64(const void *data, size_t length, std::string &str);
+
+		/// @brief CBOR encoder (RFC 8949) into a reusable buffer.
+		class CBOR {
+		private:
+			std::vector<uint8_t> buffer;
+
+			/// @brief Add data item head.
+			void head(uint8_t major, uint64_t value);
+
+		public:
+
+			/// @brief Response schema version.
+			static constexpr unsigned int SCHEMA = 1;
+
+			/// @brief Envelope keys.
+			enum Envelope : uint8_t {
+				ENVELOPE_SCHEMA		= 0,
+				ENVELOPE_TIMESTAMP	= 1,
+				ENVELOPE_DISKS		= 2,
+			};
+
+			/// @brief Disk record keys.
+			enum Key : uint8_t {
+				KEY_NAME				= 1,
+				KEY_DEVICE				= 2,
+				KEY_STATE				= 3,	///< @brief State name.
+				KEY_LEVEL				= 4,	///< @brief State level (Udjat::Level).
+				KEY_VALUE				= 5,	///< @brief Agent value.
+				KEY_TIMESTAMP			= 6,	///< @brief Last full read.
+				KEY_TEMPERATURE			= 7,	///< @brief mKelvin.
+				KEY_BADSECTORS			= 8,
+				KEY_POWERON				= 9,	///< @brief mseconds.
+				KEY_POWERCICLE			= 10,
+				KEY_SIZE				= 11,	///< @brief Bytes.
+				KEY_SERIAL				= 12,
+				KEY_FIRMWARE			= 13,
+				KEY_MODEL				= 14,
+				KEY_READ				= 15,	///< @brief Read rate (diskstats unit).
+				KEY_WRITE				= 16,	///< @brief Write rate (diskstats unit).
+				KEY_ATTRIBUTE			= 17,	///< @brief Worst attribute id.
+				KEY_ATTRIBUTE_VALUE		= 18,
+				KEY_BADSECTORS_FORECAST	= 19,	///< @brief Seconds.
+				KEY_PREFAIL_FORECAST	= 20,	///< @brief Seconds.
+				KEY_DEFERRED			= 21,
+				KEY_FAILING				= 22,
+				KEY_HOST_WRITTEN		= 23,	///< @brief Bytes since the agent started.
+				KEY_LIFE				= 24,	///< @brief SSD life left (percent, float).
+				KEY_REMAINING			= 25,	///< @brief SSD projected life left (seconds, 0 if worn out, omitted if unknown).
+			};
+
+			/// @brief Start a new payload (the buffer is kept).
+			inline void clear() noexcept {
+				buffer.clear();
+			}
+
+			inline const uint8_t * data() const noexcept {
+				return buffer.data();
+			}
+
+			inline size_t size() const noexcept {
+				return buffer.size();
+			}
+
+			/// @brief Start map.
+			/// @param items Number of pairs, -1 for an indefinite length map (closed with end()).
+			CBOR & map(ssize_t items = -1);
+
+			/// @brief Start array.
+			/// @param items Number of items, -1 for an indefinite length array (closed with end()).
+			CBOR & array(ssize_t items = -1);
+
+			/// @brief Close indefinite length map or array.
+			CBOR & end();
+
+			CBOR & integer(uint64_t value);
+			CBOR & text(const char *value);
+			CBOR & text(const std::string &value);
+			CBOR & boolean(bool value);
+			CBOR & real(float value);
+
+			template <typename T>
+			inline CBOR & integer(unsigned int key, T value) {
+				return integer(key).integer((uint64_t) value);
+			}
+
+			inline CBOR & text(unsigned int key, const char *value) {
+				return integer(key).text(value);
+			}
+
+			inline CBOR & text(unsigned int key, const std::string &value) {
+				return integer(key).text(value);
+			}
+
+			inline CBOR & boolean(unsigned int key, bool value) {
+				return integer(key).boolean(value);
+			}
+
+			inline CBOR & real(unsigned int key, float value) {
+				return integer(key).real(value);
+			}
+
+			/// @brief Get the thread's encoder, cleared.
+			static CBOR & getInstance();
+
+		};
+
+		/// @brief Get the physical device identifier (WWN) from sysfs.
+		/// @param name The kernel device name (sda).
+		/// @return The device identifier, empty if not available.
+		std::string wwid(const std::string &name);
+
+		/// @brief Block device classification, from sysfs.
+		class Device {
+		public:
+
+			enum Transport : uint8_t {
+				Unknown,
+				ATA,
+				SCSI,		///< @brief SAS and other SCSI hosts.
+				NVMe,
+				USB,
+				Virtio,
+				Virtual		///< @brief loop, zram, dm, md, nbd, ...
+			};
+
+			/// @brief Kernel device name (sda).
+			std::string name;
+
+			/// @brief Persistent identifier (WWN or, if not available, the device name).
+			std::string id;
+
+			/// @brief Is the id stable across reboots and hot plug? (false if it's the device name).
+			bool stable = false;
+
+			Transport transport = Unknown;
+			bool rotational = false;
+			bool removable = false;
+			bool optical = false;
+
+			/// @brief Classify device.
+			/// @param name The device path (/dev/sda) or kernel name (sda).
+			Device(const char *name);
+
+			const char * transport_name() const noexcept;
+
+			/// @brief Check the device against a filter list.
+			/// @param filters Comma separated list of name patterns ('sd*') or classes ('usb', 'virtual', 'rotational', 'ssd', 'removable', 'optical').
+			bool match(const char *filters) const;
+
+			/// @brief Check the include and exclude filters.
+			/// @param include Filters to include (empty to include all).
+			/// @param exclude Filters to exclude.
+			inline bool allowed(const char *include, const char *exclude) const {
+				return (!*include || match(include)) && !match(exclude);
+			}
+
+			/// @brief One time S.M.A.R.T. capability probe.
+			/// @return false if the device is known (or found) to not support S.M.A.R.T.
+			bool probe() const;
+
+		};
+
+		/// @brief Persisted cache of devices without S.M.A.R.T. support ('negative-cache' on the [smart] section).
+		class Unsupported : public Udjat::Logger {
+		private:
+			std::mutex guard;
+
+			/// @brief Cache file (empty to keep it in memory only).
+			std::string filename;
+
+			/// @brief Entry lifetime in seconds.
+			time_t ttl;
+
+			struct Entry {
+				std::string id;
+				time_t timestamp;		///< @brief Probe time.
+				bool persistent;		///< @brief Saved on the cache file.
+			};
+
+			std::vector<Entry> entries;
+
+			Unsupported();
+
+			/// @brief Write the cache file (guard must be locked).
+			void save() noexcept;
+
+		public:
+
+			static Unsupported & getInstance();
+
+			bool contains(const std::string &id);
+
+			/// @brief Add unsupported device.
+			/// @param id The device id.
+			/// @param persistent Save on the cache file (only for stable ids, the kernel names change across reboots).
+			void insert(const std::string &id, bool persistent);
+
+		};
+
+		/// @brief Device position on the storage topology, from the sysfs device path.
+		struct Location {
+
+			/// @brief Host adapter PCI address (empty if not on a PCI device).
+			std::string controller;
+
+			/// @brief SES enclosure or SAS expander (empty if directly attached).
+			std::string enclosure;
+
+			/// @brief Enclosure slot, SAS or ATA port (empty if unknown).
+			std::string slot;
+
+			/// @param name The kernel device name (sda).
+			Location(const std::string &name);
+
+		};
+
+		/// @brief Shared state of the disks on the same host adapter, detects correlated failures.
+		class Controller {
+		private:
+			std::mutex guard;
+
+			/// @brief Number of disks on the controller.
+			size_t members = 0;
+
+			/// @brief Percent of the disks failing together to consider it a controller problem.
+			unsigned int threshold;
+
+			/// @brief Failures closer than this (seconds) are correlated.
+			time_t window;
+
+			/// @brief Failing disks and the time of their last failure.
+			std::vector<std::pair<const void *,time_t>> failures;
+
+			/// @brief Current back off (seconds, 0 if not backing off).
+			time_t backoff = 0;
+
+			/// @brief End of the back off.
+			time_t until = 0;
+
+			/// @brief Number of correlated failures detected.
+			uint64_t events = 0;
+
+		public:
+
+			/// @brief Controller id (PCI address).
+			const std::string id;
+
+			Controller(const std::string &id, unsigned int threshold = 50, time_t window = 120);
+
+			inline void add() noexcept {
+				std::lock_guard<std::mutex> lock(guard);
+				members++;
+			}
+
+			/// @brief Is the controller on back off? (don't send commands to its disks).
+			bool suspended() noexcept;
+
+			/// @brief How a disk failure should be reported.
+			enum Verdict : uint8_t {
+				Isolated,		///< @brief Not correlated, report it on the disk.
+				Started,		///< @brief Started a correlated failure back off, report it once on the controller.
+				Correlated		///< @brief Part of the correlated failure, fold it into the controller state.
+			};
+
+			/// @brief Disk failed.
+			/// @param member The failing disk.
+			Verdict failed(const void *member) noexcept;
+
+			/// @brief Disk read succeeded, the controller is working.
+			void succeeded(const void *member) noexcept;
+
+			struct Status {
+				size_t members = 0;
+				size_t failing = 0;
+				time_t backoff = 0;		///< @brief Back off seconds left.
+				bool correlated = false;	///< @brief On a correlated failure (backing off or recovering from it).
+				uint64_t events = 0;
+			};
+
+			Status get() noexcept;
+
+		};
+
+		/// @brief Topology level (host adapter or enclosure) with aggregated health.
+		class Group : public Udjat::Agent<unsigned short> {
+		public:
+
+			enum Health : unsigned short {
+				Ready,
+				Warning,		///< @brief Disks with warning states.
+				Failed,			///< @brief Disks with error states.
+				Correlated		///< @brief Correlated failures, the host adapter is backing off.
+			};
+
+		private:
+
+			std::mutex guard;
+
+			struct Member {
+				std::shared_ptr<Smart::Agent> agent;
+				std::string slot;
+				std::shared_ptr<Load> load;
+			};
+
+			/// @brief Disks below this level (recursive).
+			std::vector<Member> members;
+
+			/// @brief Ready, warning and error members on the last refresh.
+			unsigned int count[3] = { 0, 0, 0 };
+
+			/// @brief Summary of the worst member state.
+			const char *worst = "";
+
+		public:
+
+			/// @brief The host adapter state (nullptr on enclosures).
+			std::shared_ptr<Controller> controller;
+
+			/// @param id The controller or enclosure id.
+			/// @param label The group label.
+			/// @param icon The group icon.
+			Group(const std::string &id, const std::string &label, const char *icon);
+
+			/// @brief Add disk to the aggregation (it's not added as child).
+			void add(std::shared_ptr<Smart::Agent> agent, const std::string &slot);
+
+			/// @brief Update the group state from the members, called after their refresh.
+			bool refresh() override;
+
+			/// @brief Export aggregated state and latency.
+			void get(const Udjat::Request &request, Udjat::Response &response) override;
+
+			std::shared_ptr<Abstract::State> computeState() override;
+
+		};
+
+		/// @brief RAID array (md or dm-raid), from sysfs and the device mapper.
+		class Array {
+		public:
+
+			enum Type : uint8_t {
+				MD,			///< @brief Linux software RAID.
+				DM			///< @brief Device mapper 'raid' target (LVM RAID).
+			};
+
+			const Type type;
+
+			/// @brief Kernel device name (md0, dm-3).
+			const std::string name;
+
+			/// @brief Array name (md name or device mapper name).
+			std::string label;
+
+			/// @brief RAID level (raid1, raid5, ...).
+			std::string level;
+
+			/// @brief Member disks (kernel names of the whole disks).
+			std::vector<std::string> members;
+
+			struct Status {
+				bool valid = false;			///< @brief false if the array status is not available.
+				bool degraded = false;		///< @brief Missing, failed or rebuilding members.
+				bool syncing = false;		///< @brief Resync, recovery, check or reshape in progress.
+				std::string action;			///< @brief Sync action (idle, resync, recover, check, ...).
+				float progress = 0;			///< @brief Sync progress in percent.
+			};
+
+			Array(Type type, const std::string &name);
+
+			/// @brief Read the current array status.
+			Status status() const noexcept;
+
+			/// @brief Get the redundant arrays.
+			static std::vector<std::shared_ptr<Array>> enumerate();
+
+		};
+
+		/// @brief Per array risk agent.
+		class ArrayAgent : public Udjat::Agent<unsigned short> {
+		public:
+
+			enum Risk : unsigned short {
+				Healthy,
+				Resync,			///< @brief Resync or check in progress.
+				AtRisk,			///< @brief Healthy array, but members report health warnings.
+				Degraded,		///< @brief Degraded or rebuilding.
+				Critical		///< @brief Degraded with members reporting health warnings.
+			};
+
+		private:
+
+			std::shared_ptr<Array> array;
+
+			/// @brief Protects the status, refreshed from the member agents and from requests.
+			std::mutex guard;
+
+			/// @brief The member disk agents.
+			std::vector<std::shared_ptr<Smart::Agent>> members;
+
+			/// @brief Last array status.
+			Array::Status status;
+
+			/// @brief Members with warning or error states.
+			unsigned int risk = 0;
+
+		public:
+
+			ArrayAgent(std::shared_ptr<Array> array);
+
+			/// @brief Add member disk.
+			inline void add(std::shared_ptr<Smart::Agent> agent) {
+				std::lock_guard<std::mutex> lock(guard);
+				members.push_back(agent);
+			}
+
+			inline bool empty() const noexcept {
+				return members.empty();
+			}
+
+			/// @brief Update the array risk, called after the member refresh.
+			bool refresh() override;
+
+			void get(const Udjat::Request &request, Udjat::Response &response) override;
+
+			std::shared_ptr<Abstract::State> computeState() override;
+
+		};
+
+		/// @brief Module wide S.M.A.R.T. command rate limiter (token bucket).
+		class RateLimiter {
+		private:
+			std::mutex guard;
+			std::condition_variable cond;
+
+			/// @brief Commands per second (0 = disabled).
+			double rate = 0;
+
+			/// @brief Bucket size.
+			double burst = 1;
+
+			/// @brief Tokens kept for refreshes, on-demand requests can't use them.
+			double reserve = 0;
+
+			/// @brief Max wait for on-demand requests.
+			std::chrono::milliseconds wait;
+
+			double tokens = 0;
+			std::chrono::steady_clock::time_point last;
+
+			/// @brief Refreshes waiting for a token.
+			size_t waiting = 0;
+
+			RateLimiter();
+
+			void refill();
+
+		public:
+
+			struct Counters {
+				uint64_t granted = 0;
+				uint64_t throttled[2] = { 0, 0 };	///< @brief Delayed operations, by priority.
+				uint64_t rejected = 0;				///< @brief On-demand requests not granted in time.
+			} counters;
+
+			static RateLimiter & getInstance();
+
+			inline bool enabled() const noexcept {
+				return rate > 0;
+			}
+
+			/// @brief Wait for a command slot.
+			/// @exception system_error (EBUSY) if an on-demand request wasn't granted in time.
+			void acquire(Disk::Priority priority);
+
+			/// @brief Get a copy of the counters.
+			Counters get();
+
+		};
+
+		/// @brief Module wide journal of agent state transitions and changed fields.
+		class Events {
+		private:
+			std::mutex guard;
+			std::condition_variable cond;
+
+			struct Event {
+				uint64_t sequence = 0;
+				time_t timestamp = 0;
+				const char *agent = "";		///< @brief Agent name.
+				const char *field = "";		///< @brief Changed field ('state', 'badsectors', ...).
+				std::string value;
+			};
+
+			/// @brief Ring buffer with the last events.
+			std::vector<Event> events;
+
+			/// @brief Last sequence number.
+			uint64_t sequence = 0;
+
+			/// @brief Max long-poll wait, in seconds.
+			unsigned int maxwait;
+
+			Events();
+
+		public:
+			static Events & getInstance();
+
+			/// @brief Record a changed field.
+			void push_back(const char *agent, const char *field, const std::string &value);
+
+			/// @brief Export events after a sequence number, waiting for new ones.
+			/// @param since The last sequence number seen by the client.
+			/// @param wait Seconds to wait when there's no new event (long-poll).
+			/// @param agent Only events from this agent (nullptr for all).
+			void get(uint64_t since, unsigned int wait, Udjat::Response &response, const char *agent = nullptr);
+
+			/// @brief Handle an event request ('?since=<sequence>&wait=<seconds>').
+			/// @return false if the request has no 'since' parameter; a malformed one sets 'error' on the response.
+			bool get(const Udjat::Request &request, Udjat::Response &response, const char *agent = nullptr);
+
+		};
+
+		/// @brief Append-only S.M.A.R.T. history store.
+		///
+		/// Samples are buffered per disk and written in blocks, one column per field,
+		/// delta and varint encoded; segment files are rotated by size.
+		class History : public Udjat::Logger {
+		public:
+
+			/// @brief Max attributes per sample.
+			static constexpr size_t MAX_ATTRIBUTES = 32;
+
+			struct Sample {
+				uint64_t timestamp = 0;
+				uint64_t value = 0;			///< @brief Agent value (overall).
+				uint64_t temperature = 0;	///< @brief mKelvin.
+				uint64_t badsectors = 0;
+				uint64_t poweron = 0;		///< @brief mseconds.
+				uint64_t powercicle = 0;
+				size_t attributes = 0;
+				struct {
+					uint8_t id;
+					uint64_t raw;
+				} attribute[MAX_ATTRIBUTES];
+			};
+
+		private:
+			std::mutex guard;
+
+			/// @brief Segment directory (empty if disabled).
+			std::string path;
+
+			/// @brief Segment file prefix (host name).
+			std::string prefix;
+
+			size_t segment_size;
+			size_t segments;
+			size_t batch;
+
+			/// @brief Current segment number.
+			unsigned int current = 0;
+
+			/// @brief Time range of a closed segment.
+			struct Range {
+				uint64_t from = 0;
+				uint64_t to = 0;
+			};
+
+			/// @brief Time index of the closed segments, built on the first query that reads them.
+			std::map<unsigned int,Range> index;
+
+			/// @brief Pending samples, per disk.
+			struct Series {
+				const char *name;
+				std::vector<Sample> samples;
+			};
+
+			std::vector<Series> series;
+
+			History();
+
+			std::string filename(unsigned int segment) const;
+
+			/// @brief Write the pending samples of a disk (guard must be locked).
+			void flush(Series &series);
+
+			/// @brief Get the time range of the samples on a memory mapped segment.
+			/// @return false if the segment has no samples.
+			static bool range(const uint8_t *data, size_t length, Range &range);
+
+			/// @brief Decode blocks from a memory mapped segment.
+			static void decode(const uint8_t *data, size_t length, const char *name, uint64_t from, uint64_t to, const std::function<void(const Sample &)> &call);
+
+		public:
+			~History();
+
+			static History & getInstance();
+
+			inline bool enabled() const noexcept {
+				return !path.empty();
+			}
+
+			void push_back(const char *name, const Sample &sample);
+
+			/// @brief Get samples in time range (stored and pending).
+			void get(const char *name, uint64_t from, uint64_t to, const std::function<void(const Sample &)> &call);
+
+		};
+
+		/// @brief Contiguous pooled storage for compact mode agents.
+		/// @details Allocations are never released one by one, the memory goes away with the arena,
+		/// when the last object using it is destroyed.
+		class Arena {
+		private:
+			std::mutex guard;
+
+			/// @brief Block size.
+			size_t length;
+
+			/// @brief Free space on the last block.
+			size_t available = 0;
+
+			std::vector<std::unique_ptr<uint8_t[]>> blocks;
+
+			/// @brief Reserved bytes (blocks).
+			size_t reserved = 0;
+
+			/// @brief Allocated bytes.
+			size_t used = 0;
+
+		public:
+
+			/// @param length Block size, allocations larger than it get their own block.
+			Arena(size_t length);
+
+			void * allocate(size_t size, size_t alignment);
+
+			/// @brief Get reserved and allocated bytes.
+			void get(size_t &reserved, size_t &used);
+
+			/// @brief Arena allocator, for std::allocate_shared.
+			template <typename T>
+			class Allocator {
+			public:
+				typedef T value_type;
+
+				std::shared_ptr<Arena> arena;
+
+				Allocator(const std::shared_ptr<Arena> &arena) noexcept : arena{arena} {
+				}
+
+				template <typename U>
+				Allocator(const Allocator<U> &other) noexcept : arena{other.arena} {
+				}
+
+				T * allocate(size_t n) {
+					return (T *) arena->allocate(n * sizeof(T), alignof(T));
+				}
+
+				void deallocate(T UDJAT_UNUSED(*ptr), size_t UDJAT_UNUSED(n)) noexcept {
+					// Released with the arena.
+				}
+
+				template <typename U>
+				bool operator==(const Allocator<U> &other) const noexcept {
+					return arena == other.arena;
+				}
+
+				template <typename U>
+				bool operator!=(const Allocator<U> &other) const noexcept {
+					return arena != other.arena;
+				}
+
+			};
+
+		};
+
+		/// @brief Bounded string pool for compact mode agents ('string-pool-size' on the [smart] section).
+		class Strings {
+		private:
+			std::mutex guard;
+
+			std::unordered_set<std::string> strings;
+
+			/// @brief Max pool size in bytes.
+			size_t limit;
+
+			/// @brief Pool size in bytes.
+			size_t used = 0;
+
+			Strings();
+
+		public:
+
+			static Strings & getInstance();
+
+			/// @brief Get pooled copy of a string.
+			/// @param str The string to intern.
+			/// @param fallback Returned when the pool is full.
+			const char * get(const std::string &str, const char *fallback = "");
+
+			/// @brief Get pool size in bytes.
+			size_t size();
+
+		};
+
+		/// @brief Module wide registry of the device agents, keeps them across configuration reloads.
+		class Registry {
+		private:
+			std::mutex guard;
+
+			struct Entry {
+				std::string name;				///< @brief Device name (first path) and definition position.
+				uint64_t signature = 0;			///< @brief Hash of the agent definition.
+				std::weak_ptr<Smart::Agent> agent;
+			};
+
+			std::vector<Entry> entries;
+
+			Registry() = default;
+
+		public:
+
+			static Registry & getInstance();
+
+			/// @brief Get the signature of an agent definition.
+			/// @param paths The device paths.
+			/// @param node The agent node (attributes and children, recursively).
+			/// @param ignore Null terminated list of node attributes not used by the agent.
+			static uint64_t signature(const std::vector<std::string> &paths, const pugi::xml_node &node, const char **ignore = nullptr) noexcept;
+
+			/// @brief Get agent for device, reuses the existing one if its definition didn't change.
+			/// @param paths The device paths, the first one and the node position are the registry key.
+			/// @param node The agent definition.
+			/// @param arena Storage for a new agent (nullptr to use the heap).
+			/// @param ignore Null terminated list of node attributes not used by the agent.
+			std::shared_ptr<Smart::Agent> get(const std::vector<std::string> &paths, const pugi::xml_node &node, const std::shared_ptr<Arena> &arena = std::shared_ptr<Arena>(), const char **ignore = nullptr);
+
+		};
+
+		/// @brief libatasmart backend (ATA/SATA devices).
+		class ATABackend : public Disk::Backend {
+		private:
+			SkDisk *d = nullptr;
+
+		public:
+			ATABackend(const char *name);
+
+			/// @brief Open recorded blob (from sk_disk_get_blob).
+			ATABackend(const std::string &blob);
+
+			virtual ~ATABackend();
+
+			void read() override;
+			bool status() override;
+			bool identify_is_available() override;
+			const SkIdentifyParsedData * identify() override;
+			SkSmartOverall overall() override;
+			bool is_awake() override;
+			uint64_t size() override;
+			uint64_t badsectors() override;
+			uint64_t poweron() override;
+			uint64_t powercicle() override;
+			uint64_t temperature() override;
+			std::string blob() override;
+			void attributes(Callback call, void *userdata) override;
+
+		};
+
+		/// @brief NVMe backend, reads the SMART/Health Information log page.
+		class NVMeBackend : public Disk::Backend {
+		private:
+
+			/// @brief Device or recorded log page file name.
+			std::string name;
+
+			/// @brief Device handle (-1 when reading from a recorded log page).
+			int fd = -1;
+
+			/// @brief Is the data from a recorded log page file?
+			bool recorded = false;
+
+			/// @brief The SMART/Health Information log page (NVMe 1.4, figure 194).
+			uint8_t log[512];
+
+			/// @brief Identify data, parsed from the identify controller page.
+			SkIdentifyParsedData ipd;
+
+			/// @brief Is the identify data valid?
+			bool ipd_valid = false;
+
+			uint64_t le64(size_t offset) const noexcept;
+
+			void admin(uint8_t opcode, uint32_t nsid, uint32_t cdw10, void *data, uint32_t length);
+
+		public:
+
+			/// @brief Open NVMe device or recorded log page.
+			/// @param name The device name (/dev/nvme0n1) or the path of a recorded log page.
+			/// @param recorded true if name is a recorded log page file.
+			NVMeBackend(const char *name, bool recorded = false);
+			virtual ~NVMeBackend();
+
+			void read() override;
+			bool identify_is_available() override;
+			const SkIdentifyParsedData * identify() override;
+			SkSmartOverall overall() override;
+			bool is_awake() override;
+			uint64_t size() override;
+			uint64_t badsectors() override;
+			uint64_t poweron() override;
+			uint64_t powercicle() override;
+			uint64_t temperature() override;
+			std::string blob() override;
+			void attributes(Callback call, void *userdata) override;
+
+		};
+
+	}
+
+ }
+
 
@@ -0,0 +1,400 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the RAID membership and the array risk agent.
+  *
+  * md arrays are read from /sys/block/md<n>/md (Documentation/admin-guide/md.rst).
+  *
+  * dm-raid status comes from DM_TABLE_STATUS, the 'raid' target reports
+  * '<raid_type> <#devices> <health_chars> <sync_ratio> <sync_action> <mismatch_cnt>'
+  * (Documentation/admin-guide/device-mapper/dm-raid.rst).
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/quark.h>
+ #include <udjat/tools/intl.h>
+ #include <linux/dm-ioctl.h>
+ #include <sys/ioctl.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <dirent.h>
+ #include <climits>
+ #include <cstring>
+ #include <fstream>
+ #include <sstream>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Read the first line of a sysfs file.
+	static string sysfs(const string &path) {
+		ifstream in{path};
+		string value;
+		if(in) {
+			getline(in,value);
+		}
+		while(!value.empty() && isspace(value.back())) {
+			value.pop_back();
+		}
+		return value;
+	}
+
+	/// @brief Get the whole disks under a block device (partitions and stacked devices resolved).
+	static void disks(const string &name, vector<string> &members, unsigned int depth = 0) {
+
+		if(depth > 8) {
+			return;
+		}
+
+		string path{string{"/sys/class/block/"} + name};
+
+		if(!access((path + "/partition").c_str(),F_OK)) {
+
+			// Partition, the parent directory is the disk.
+			char buffer[PATH_MAX+1];
+			if(realpath(path.c_str(),buffer)) {
+				char *ptr = strrchr(buffer,'/');
+				if(ptr) {
+					*ptr = 0;
+					ptr = strrchr(buffer,'/');
+					if(ptr) {
+						disks(ptr+1,members,depth+1);
+					}
+				}
+			}
+			return;
+
+		}
+
+		DIR *dir = opendir((path + "/slaves").c_str());
+		if(dir) {
+
+			bool stacked = false;
+			struct dirent *entry;
+			while((entry = readdir(dir)) != NULL) {
+				if(entry->d_name[0] != '.') {
+					stacked = true;
+					disks(entry->d_name,members,depth+1);
+				}
+			}
+			closedir(dir);
+
+			if(stacked) {
+				return;
+			}
+
+		}
+
+		for(auto &member : members) {
+			if(member == name) {
+				return;
+			}
+		}
+
+		members.push_back(name);
+
+	}
+
+	/// @brief Get the device mapper target status.
+	/// @return false if not available.
+	static bool dm_status(const string &name, string &type, string &params) {
+
+		int fd = open("/dev/mapper/control",O_RDWR|O_CLOEXEC);
+		if(fd < 0) {
+			return false;
+		}
+
+		union {
+			struct dm_ioctl io;
+			char buffer[16384];
+		} data;
+
+		memset(&data,0,sizeof(data));
+		data.io.version[0] = DM_VERSION_MAJOR;
+		data.io.data_size = sizeof(data);
+		data.io.data_start = sizeof(struct dm_ioctl);
+		strncpy(data.io.name,name.c_str(),DM_NAME_LEN-1);
+
+		int rc = ioctl(fd,DM_TABLE_STATUS,&data.io);
+		close(fd);
+
+		if(rc || !data.io.target_count || data.io.data_start + sizeof(struct dm_target_spec) >= sizeof(data)) {
+			return false;
+		}
+
+		const struct dm_target_spec *spec = (const struct dm_target_spec *) (data.buffer + data.io.data_start);
+
+		data.buffer[sizeof(data.buffer)-1] = 0;
+		type = string{spec->target_type,strnlen(spec->target_type,DM_MAX_TYPE_NAME)};
+		params = (const char *) (spec+1);
+
+		return true;
+
+	}
+
+	Smart::Array::Array(Type t, const std::string &n) : type{t}, name{n} {
+
+		string path{string{"/sys/block/"} + name};
+
+		if(type == MD) {
+			label = name;
+			level = sysfs(path + "/md/level");
+		} else {
+			label = sysfs(path + "/dm/name");
+			level = "raid";
+		}
+
+		disks(name,members);
+
+	}
+
+	Smart::Array::Status Smart::Array::status() const noexcept {
+
+		Status status;
+
+		try {
+
+			if(type == MD) {
+
+				string path{string{"/sys/block/"} + name + "/md/"};
+
+				string degraded = sysfs(path + "degraded");
+				if(degraded.empty()) {
+					return status;
+				}
+
+				status.valid = true;
+				status.action = sysfs(path + "sync_action");
+				status.syncing = !(status.action.empty() || status.action == "idle" || status.action == "frozen");
+				status.degraded = (atoi(degraded.c_str()) > 0 || status.action == "recover");
+
+				// 'done / total' in sectors, 'none' if idle.
+				unsigned long long done, total;
+				if(sscanf(sysfs(path + "sync_completed").c_str(),"%llu / %llu",&done,&total) == 2 && total) {
+					status.progress = ((float) done * 100) / ((float) total);
+				}
+
+			} else {
+
+				string type, params;
+				if(!dm_status(label,type,params) || type != "raid") {
+					return status;
+				}
+
+				istringstream in{params};
+				string raid, devices, health, ratio;
+				if(!(in >> raid >> devices >> health >> ratio >> status.action)) {
+					return status;
+				}
+
+				status.valid = true;
+
+				// 'D' is a dead member; 'a' is alive but not in sync, as on the initial sync.
+				status.degraded = (health.find('D') != string::npos);
+				status.syncing = (health.find('a') != string::npos || !(status.action == "idle" || status.action == "frozen"));
+
+				unsigned long long done, total;
+				if(sscanf(ratio.c_str(),"%llu/%llu",&done,&total) == 2 && total) {
+					status.progress = ((float) done * 100) / ((float) total);
+				}
+
+			}
+
+		} catch(...) {
+
+			status.valid = false;
+
+		}
+
+		return status;
+
+	}
+
+	std::vector<std::shared_ptr<Smart::Array>> Smart::Array::enumerate() {
+
+		std::vector<std::shared_ptr<Smart::Array>> arrays;
+
+		DIR *dir = opendir("/sys/block");
+		if(!dir) {
+			return arrays;
+		}
+
+		struct dirent *entry;
+		while((entry = readdir(dir)) != NULL) {
+
+			string name{entry->d_name};
+
+			if(!strncmp(name.c_str(),"md",2) && isdigit(name[2])) {
+
+				// md array, raid0 and linear have no redundancy.
+				string level = sysfs(string{"/sys/block/"} + name + "/md/level");
+				if(strncmp(level.c_str(),"raid",4) || level == "raid0") {
+					continue;
+				}
+
+				arrays.push_back(make_shared<Array>(MD,name));
+
+			} else if(!strncmp(name.c_str(),"dm-",3)) {
+
+				// Device mapper, only the 'raid' target.
+				string type, params;
+				if(!dm_status(sysfs(string{"/sys/block/"} + name + "/dm/name"),type,params) || type != "raid") {
+					continue;
+				}
+
+				arrays.push_back(make_shared<Array>(DM,name));
+
+			}
+
+		}
+
+		closedir(dir);
+
+		return arrays;
+
+	}
+
+	Smart::ArrayAgent::ArrayAgent(std::shared_ptr<Array> a) : Udjat::Agent<unsigned short>(Quark(a->name).c_str(),Healthy), array{a} {
+		Object::properties.icon = "drive-multidisk";
+		Object::properties.label = Quark(string{"RAID array "} + array->label).c_str();
+		Object::properties.summary = Quark(array->level).c_str();
+	}
+
+	bool Smart::ArrayAgent::refresh() {
+
+		Array::Status current = array->status();
+
+		lock_guard<mutex> lock(guard);
+
+		status = current;
+
+		risk = 0;
+		for(auto &member : members) {
+			auto state = member->state();
+			if(state && state->level() >= Udjat::warning) {
+				risk++;
+			}
+		}
+
+		unsigned short previous = super::get();
+		unsigned short value = Healthy;
+
+		if(status.degraded) {
+			value = (risk ? Critical : Degraded);
+		} else if(risk) {
+			value = AtRisk;
+		} else if(status.syncing) {
+			value = Resync;
+		}
+
+		set(value);
+
+		if(value != previous) {
+			Events::getInstance().push_back(name(),"state",computeState()->name());
+		}
+
+		return true;
+
+	}
+
+	void Smart::ArrayAgent::get(const Udjat::Request &request, Udjat::Response &response) {
+
+		refresh();
+
+		Udjat::Abstract::Agent::get(request,response);
+
+		lock_guard<mutex> lock(guard);
+
+		response["level"] = array->level;
+		response["valid"] = status.valid;
+		response["degraded"] = status.degraded;
+		response["action"] = status.action;
+		response["progress"] = status.progress;
+		response["risk"] = risk;
+
+		Udjat::Value &values = response["members"];
+		for(auto &member : members) {
+			Udjat::Value &value = values.append();
+			auto state = member->state();
+			value["name"] = member->name();
+			value["state"] = (state ? state->summary() : "");
+		}
+
+	}
+
+	std::shared_ptr<Abstract::State> Smart::ArrayAgent::computeState() {
+
+		unsigned short value = super::get();
+
+		for(auto state : states) {
+			if(state->compare(value))
+				return state;
+		}
+
+		static const struct {
+			unsigned short					  value;
+			const char 						* name;
+			Udjat::Level					  level;
+			const char						* summary;
+		} predefined_states[] = {
+			{ Healthy,	"healthy",	Udjat::ready,	N_( "RAID array is healthy" )								},
+			{ Resync,	"resync",	Udjat::ready,	N_( "RAID array resync in progress" )						},
+			{ AtRisk,	"atrisk",	Udjat::warning,	N_( "RAID array members report health warnings" )			},
+			{ Degraded,	"degraded",	Udjat::error,	N_( "RAID array is degraded" )								},
+			{ Critical,	"critical",	Udjat::critical,N_( "Degraded RAID array members report health warnings" )	},
+		};
+
+		for(size_t ix = 0; ix < N_ELEMENTS(predefined_states); ix++) {
+
+			if(predefined_states[ix].value == value) {
+
+#ifdef GETTEXT_PACKAGE
+				string summary{dgettext(GETTEXT_PACKAGE,predefined_states[ix].summary)};
+#else
+				string summary{predefined_states[ix].summary};
+#endif // GETTEXT_PACKAGE
+
+				summary += " (";
+				summary += array->label;
+				summary += ")";
+
+				auto new_state =
+					make_shared<Udjat::State<unsigned short>>(
+						predefined_states[ix].name,
+						predefined_states[ix].value,
+						predefined_states[ix].level,
+						Quark(summary).c_str(),
+						""
+					);
+
+				states.push_back(new_state);
+				return new_state;
+
+			}
+
+		}
+
+		return Abstract::Agent::computeState();
+
+	}
+
+ }
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the module wide S.M.A.R.T. command rate limiter.
+  *
+  * <https://en.wikipedia.org/wiki/Token_bucket>
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/configuration.h>
+
+ using namespace std;
+ using namespace std::chrono;
+
+ namespace Udjat {
+
+	Smart::RateLimiter::RateLimiter() {
+
+		rate = atof(Config::Value<string>("smart","max-commands-per-second","0").c_str());
+		burst = atof(Config::Value<string>("smart","max-commands-burst","4").c_str());
+		wait = milliseconds(atoi(Config::Value<string>("smart","request-wait","1000").c_str()));
+
+		if(burst < 1) {
+			burst = 1;
+		}
+
+		// Half of the spare bucket is reserved for refreshes.
+		reserve = (burst - 1) / 2;
+		tokens = burst;
+		last = steady_clock::now();
+
+	}
+
+	Smart::RateLimiter & Smart::RateLimiter::getInstance() {
+		static RateLimiter instance;
+		return instance;
+	}
+
+	void Smart::RateLimiter::refill() {
+
+		auto now = steady_clock::now();
+		double elapsed = duration_cast<duration<double>>(now - last).count();
+		last = now;
+
+		tokens += (elapsed * rate);
+		if(tokens > burst) {
+			tokens = burst;
+		}
+
+	}
+
+	void Smart::RateLimiter::acquire(Disk::Priority priority) {
+
+		if(!enabled()) {
+			return;
+		}
+
+		unique_lock<mutex> lock(guard);
+
+		bool throttled = false;
+		auto deadline = steady_clock::now() + wait;
+
+		if(priority == Disk::Refresh) {
+			waiting++;
+		}
+
+		while(true) {
+
+			refill();
+
+			// On-demand reads never use the reserved tokens or pass a waiting refresh.
+			double required = (priority == Disk::Request ? 1 + reserve : 1);
+
+			if(tokens >= required && (priority == Disk::Refresh || !waiting)) {
+				tokens -= 1;
+				counters.granted++;
+				if(priority == Disk::Refresh) {
+					waiting--;
+				}
+				break;
+			}
+
+			if(!throttled) {
+				counters.throttled[priority]++;
+				throttled = true;
+			}
+
+			auto now = steady_clock::now();
+			auto next = now + duration_cast<steady_clock::duration>(duration<double>((tokens < required ? required - tokens : 1) / rate));
+
+			if(priority == Disk::Request) {
+
+				if(now >= deadline) {
+					counters.rejected++;
+					throw system_error(EBUSY, system_category(), "S.M.A.R.T. command rate exceeded");
+				}
+
+				if(next > deadline) {
+					next = deadline;
+				}
+
+			}
+
+			cond.wait_until(lock,next);
+
+		}
+
+		cond.notify_all();
+
+	}
+
+	Smart::RateLimiter::Counters Smart::RateLimiter::get() {
+		lock_guard<mutex> lock(guard);
+		return counters;
+	}
+
+ }
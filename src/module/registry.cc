@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the device agent registry.
+  *
+  * On configuration reload the factory is called again for every atasmart node; agents
+  * whose definition (device paths, timers, diskstats, states, attribute overrides, ...)
+  * didn't change are reused, keeping the open handles, cached identify data, trends and
+  * sampler threads. Only the changed ones are rebuilt.
+  *
+  * Agents are keyed by device and by the position of their definition on the configuration,
+  * a device listed twice (or on its own node and on a physical disks container) gets one
+  * agent for each parent.
+  *
+  */
+
+ #include "private.h"
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief FNV-1a, 64 bits.
+	static uint64_t hash(uint64_t value, const char *str) noexcept {
+		if(str) {
+			while(*str) {
+				value ^= (uint8_t) *(str++);
+				value *= 0x100000001b3ULL;
+			}
+		}
+		// Separator, "ab"+"c" must not match "a"+"bc".
+		value ^= 0xff;
+		value *= 0x100000001b3ULL;
+		return value;
+	}
+
+	static uint64_t hash(uint64_t value, const pugi::xml_node &node, const char **ignore = nullptr) noexcept {
+
+		value = hash(value,node.name());
+		value = hash(value,node.value());
+
+		for(pugi::xml_attribute attribute = node.first_attribute(); attribute; attribute = attribute.next_attribute()) {
+
+			bool skip = false;
+			for(const char **name = ignore; name && *name && !skip; name++) {
+				skip = !strcmp(attribute.name(),*name);
+			}
+
+			if(skip) {
+				continue;
+			}
+
+			value = hash(value,attribute.name());
+			value = hash(value,attribute.value());
+		}
+
+		for(pugi::xml_node child = node.first_child(); child; child = child.next_sibling()) {
+			value = hash(value,child);
+		}
+
+		// End of node.
+		return hash(value,"/");
+
+	}
+
+	Smart::Registry & Smart::Registry::getInstance() {
+		static Registry instance;
+		return instance;
+	}
+
+	/// @brief Position of the node on the configuration ('/config[0]/atasmart[1]').
+	static string location(const pugi::xml_node &node) {
+
+		string path;
+
+		for(pugi::xml_node element = node; element && *element.name(); element = element.parent()) {
+
+			size_t index = 0;
+			for(pugi::xml_node sibling = element.previous_sibling(element.name()); sibling; sibling = sibling.previous_sibling(element.name())) {
+				index++;
+			}
+
+			path = string{"/"} + element.name() + "[" + std::to_string(index) + "]" + path;
+
+		}
+
+		return path;
+
+	}
+
+	uint64_t Smart::Registry::signature(const std::vector<std::string> &paths, const pugi::xml_node &node, const char **ignore) noexcept {
+
+		uint64_t value = 0xcbf29ce484222325ULL;
+
+		for(auto &path : paths) {
+			value = hash(value,path.c_str());
+		}
+
+		return hash(value,node,ignore);
+
+	}
+
+	std::shared_ptr<Smart::Agent> Smart::Registry::get(const std::vector<std::string> &paths, const pugi::xml_node &node, const std::shared_ptr<Arena> &arena, const char **ignore) {
+
+		string name{paths.at(0)};
+		name += location(node);
+
+		uint64_t signature = Registry::signature(paths,node,ignore);
+
+		lock_guard<mutex> lock(guard);
+
+		Entry *entry = nullptr;
+		for(auto it = entries.begin(); it != entries.end();) {
+
+			if(it->agent.expired()) {
+				// Agent was released by an older configuration, forget it.
+				it = entries.erase(it);
+				continue;
+			}
+
+			if(it->name == name) {
+				entry = &(*it);
+			}
+
+			it++;
+		}
+
+		if(entry && entry->signature == signature) {
+			auto agent = entry->agent.lock();
+			if(agent) {
+				// Same definition, keep the agent and its state.
+				return agent;
+			}
+		}
+
+		std::shared_ptr<Smart::Agent> agent;
+		if(arena) {
+			agent = allocate_shared<Smart::Agent>(Arena::Allocator<Smart::Agent>(arena),paths,node);
+		} else {
+			agent = make_shared<Smart::Agent>(paths,node);
+		}
+
+		if(entry) {
+			// Definition changed, replace the old agent.
+			entry->signature = signature;
+			entry->agent = agent;
+		} else {
+			entries.push_back(Entry{name,signature,agent});
+		}
+
+		return agent;
+
+	}
+
+ }
@@ -18,7 +18,8 @@
  */
 
  #include <udjat/tools/temperature.h>
- #include <sstream>
+ #include <cstdio>
+ #include <stdexcept>
  #include <cmath>
 
  using namespace std;
@@ -108,19 +109,21 @@
 	}
 
 	std::string Temperature::to_string() const {
+		char buffer[24];
+		return std::string{to_string(buffer,sizeof(buffer))};
+	}
+
+	const char * Temperature::to_string(char *buffer, size_t length) const noexcept {
 
 		if(FP_ZERO == fpclassify(this->value)) {
-			return "";
+			*buffer = 0;
+			return buffer;
 		}
 
-		// https://www.delftstack.com/howto/cpp/how-to-convert-float-to-string-in-cpp/
-		// https://www.delftstack.com/howto/cpp/cpp-round-to-2-decimals/
-		std::stringstream sstream;
-
-		sstream << this->value;
-		sstream << " °" << ((char) this->unity);
+		// Same as the stream default (6 significant digits, no trailing zeros).
+		snprintf(buffer,length,"%g °%c",this->value,(char) this->unity);
 
-		return sstream.str();
+		return buffer;
 
 	}
 
@@ -0,0 +1,470 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the high frequency temperature sampler.
+  *
+  * <https://www.kernel.org/doc/html/latest/hwmon/drivetemp.html>
+  * <https://www.t10.org/ftp/t10/document.04/04-262r8.pdf> (ATA PASS-THROUGH)
+  * ATA8-ACS, 8.3.2 (SCT status response).
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/smart/thermal.h>
+ #include <udjat/tools/logger.h>
+ #include <list>
+ #include <algorithm>
+ #include <thread>
+ #include <glob.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/ioctl.h>
+ #include <sys/stat.h>
+ #include <scsi/sg.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Sampler thread, runs while there are registered samplers.
+	class ThermalController {
+	private:
+
+		/// @brief Serializes thread start/stop.
+		mutex control;
+
+		/// @brief Protects the sampler list.
+		mutex guard;
+
+		condition_variable cond;
+		list<Smart::Thermal *> samplers;
+		thread *worker = nullptr;
+
+		/// @brief Sampler being read, remove() waits for it.
+		Smart::Thermal *active = nullptr;
+
+		ThermalController() = default;
+
+		void run() {
+
+			unique_lock<mutex> lock(guard);
+
+			while(!samplers.empty()) {
+
+				time_t now = time(nullptr);
+
+				// Sample without the lock, reads can block on the device or on the rate limiter.
+				list<Smart::Thermal *> pending{samplers};
+				for(auto sampler : pending) {
+
+					if(find(samplers.begin(),samplers.end(),sampler) == samplers.end()) {
+						continue;	// Removed while sampling the previous ones.
+					}
+
+					active = sampler;
+					lock.unlock();
+					sampler->sample(now);
+					lock.lock();
+					active = nullptr;
+					cond.notify_all();
+
+				}
+
+				if(!samplers.empty()) {
+					cond.wait_for(lock,chrono::seconds(1));
+				}
+
+			}
+
+		}
+
+	public:
+		static ThermalController & getInstance() {
+			static ThermalController instance;
+			return instance;
+		}
+
+		void insert(Smart::Thermal *sampler) {
+
+			lock_guard<mutex> serialize(control);
+			lock_guard<mutex> lock(guard);
+
+			samplers.push_back(sampler);
+
+			if(!worker) {
+				worker = new thread([this](){ run(); });
+			}
+
+		}
+
+		void remove(Smart::Thermal *sampler) {
+
+			lock_guard<mutex> serialize(control);
+			thread *stopped = nullptr;
+
+			{
+				unique_lock<mutex> lock(guard);
+				samplers.remove(sampler);
+
+				// Don't return while the sampler is in use.
+				cond.wait(lock,[this,sampler](){ return active != sampler; });
+
+				if(samplers.empty()) {
+					stopped = worker;
+					worker = nullptr;
+				}
+			}
+
+			if(stopped) {
+				// Joined with 'control' held, insert() can't start another thread meanwhile.
+				cond.notify_all();
+				stopped->join();
+				delete stopped;
+			}
+
+		}
+
+	};
+
+	/// @brief Read the SCT status temperature using ATA PASS-THROUGH(16).
+	/// @param celsius The temperature in Celsius.
+	/// @return false if not available.
+	static bool sct_temperature(const char *devicename, float &celsius) {
+
+		int fd = open(devicename,O_RDONLY|O_NONBLOCK);
+		if(fd < 0) {
+			return false;
+		}
+
+		uint8_t cdb[16];
+		memset(cdb,0,sizeof(cdb));
+
+		cdb[0] = 0x85;		// ATA PASS-THROUGH(16)
+		cdb[1] = (4 << 1);	// PIO data-in
+		cdb[2] = 0x0E;		// T_DIR=1, BYT_BLOK=1, T_LENGTH=sector count
+		cdb[4] = 0xD5;		// SMART READ LOG
+		cdb[6] = 0x01;		// 1 sector
+		cdb[8] = 0xE0;		// SCT command/status log
+		cdb[10] = 0x4F;
+		cdb[12] = 0xC2;
+		cdb[14] = 0xB0;		// SMART
+
+		uint8_t data[512];
+		uint8_t sense[32];
+
+		memset(data,0,sizeof(data));
+
+		sg_io_hdr_t io;
+		memset(&io,0,sizeof(io));
+
+		io.interface_id = 'S';
+		io.dxfer_direction = SG_DXFER_FROM_DEV;
+		io.cmd_len = sizeof(cdb);
+		io.cmdp = cdb;
+		io.dxfer_len = sizeof(data);
+		io.dxferp = data;
+		io.mx_sb_len = sizeof(sense);
+		io.sbp = sense;
+		io.timeout = 5000;
+
+		int rc = ioctl(fd,SG_IO,&io);
+		close(fd);
+
+		if(rc < 0 || io.host_status || (io.status & 0x7E) == 0x02) {
+			return false;
+		}
+
+		// SCT status format version 2 or 3, current temperature at offset 200 (0x80 = invalid).
+		uint16_t version = data[0] | (data[1] << 8);
+		if((version != 2 && version != 3) || data[200] == 0x80) {
+			return false;
+		}
+
+		celsius = (float) ((int8_t) data[200]);
+		return true;
+
+	}
+
+	void Smart::Thermal::Window::reset(time_t s) noexcept {
+		seconds = s;
+		for(Bucket &bucket : buckets) {
+			bucket.count = 0;
+			bucket.slot = 0;
+		}
+	}
+
+	void Smart::Thermal::Window::push_back(float celsius, time_t timestamp) noexcept {
+
+		if(!seconds) {
+			return;
+		}
+
+		time_t width = (seconds >= (time_t) BUCKETS ? seconds / BUCKETS : 1);
+		time_t slot = timestamp / width;
+		Bucket &bucket = buckets[slot % BUCKETS];
+
+		if(bucket.slot != slot || !bucket.count) {
+			bucket.slot = slot;
+			bucket.min = bucket.max = bucket.sum = celsius;
+			bucket.count = 1;
+			return;
+		}
+
+		if(celsius < bucket.min) {
+			bucket.min = celsius;
+		}
+
+		if(celsius > bucket.max) {
+			bucket.max = celsius;
+		}
+
+		bucket.sum += celsius;
+		bucket.count++;
+
+	}
+
+	Smart::Thermal::Window::Value Smart::Thermal::Window::get(time_t timestamp) const noexcept {
+
+		Value value;
+
+		if(!seconds) {
+			return value;
+		}
+
+		time_t width = (seconds >= (time_t) BUCKETS ? seconds / BUCKETS : 1);
+		time_t slot = timestamp / width;
+		float sum = 0;
+
+		for(const Bucket &bucket : buckets) {
+
+			if(!bucket.count || bucket.slot <= (slot - (time_t) BUCKETS) || bucket.slot > slot) {
+				continue;
+			}
+
+			if(!value.count || bucket.min < value.min) {
+				value.min = bucket.min;
+			}
+
+			if(!value.count || bucket.max > value.max) {
+				value.max = bucket.max;
+			}
+
+			sum += bucket.sum;
+			value.count += bucket.count;
+
+		}
+
+		if(value.count) {
+			value.avg = sum / value.count;
+		}
+
+		return value;
+
+	}
+
+	Smart::Thermal::Thermal(const char *name, time_t i, const char *w) : devicename{name}, interval{i ? i : 1} {
+
+		size_t ix = 0;
+		while(w && *w && ix < MAX_WINDOWS) {
+			time_t seconds = (time_t) atol(w);
+			if(seconds > 0) {
+				windows[ix++].reset(seconds);
+			}
+			w = strchr(w,',');
+			if(w) {
+				w++;
+			}
+		}
+
+		ThermalController::getInstance().insert(this);
+
+	}
+
+	Smart::Thermal::~Thermal() {
+		ThermalController::getInstance().remove(this);
+	}
+
+	void Smart::Thermal::detect() {
+
+		const char *ptr = strrchr(devicename.c_str(),'/');
+		string name{ptr ? ptr+1 : devicename.c_str()};
+
+		// Kernel sensor (drivetemp for ATA, nvme driver for NVMe controllers).
+		for(const char *pattern : { "/sys/block/%s/device/hwmon/hwmon*/temp1_input", "/sys/block/%s/device/hwmon*/temp1_input" }) {
+
+			char path[256];
+			snprintf(path,sizeof(path),pattern,name.c_str());
+
+			glob_t gl;
+			if(!glob(path,0,NULL,&gl)) {
+				if(gl.gl_pathc) {
+					sensor = gl.gl_pathv[0];
+				}
+			}
+			globfree(&gl);
+
+			if(!sensor.empty()) {
+				source = HWMon;
+				return;
+			}
+
+		}
+
+		struct stat st;
+		if(!strncmp(name.c_str(),"nvme",4) || (!::stat(devicename.c_str(),&st) && S_ISREG(st.st_mode))) {
+			source = NVMe;
+			return;
+		}
+
+		float celsius;
+		source = (sct_temperature(devicename.c_str(),celsius) ? SCT : Unavailable);
+
+	}
+
+	bool Smart::Thermal::read(float &celsius) {
+
+		if(source == None) {
+			detect();
+		}
+
+		switch(source) {
+		case HWMon:
+			{
+				FILE *in = fopen(sensor.c_str(),"r");
+				if(!in) {
+					return false;
+				}
+				long millidegrees = 0;
+				int rc = fscanf(in,"%ld",&millidegrees);
+				fclose(in);
+				if(rc != 1) {
+					return false;
+				}
+				celsius = ((float) millidegrees) / 1000;
+				return true;
+			}
+
+		case SCT:
+			// SCT status is a device command, it goes through the rate limiter.
+			RateLimiter::getInstance().acquire(Disk::Request);
+			return sct_temperature(devicename.c_str(),celsius);
+
+		case NVMe:
+			{
+				Smart::Disk disk(devicename.c_str(),Disk::Request);
+				celsius = disk.read().temperature().as_celsius();
+				return true;
+			}
+
+		default:
+			return false;
+
+		}
+
+	}
+
+	void Smart::Thermal::rebind(const char *name) {
+		lock_guard<mutex> lock(guard);
+		rebound = name;
+	}
+
+	void Smart::Thermal::sample(time_t timestamp) noexcept {
+
+		{
+			lock_guard<mutex> lock(guard);
+			if(!rebound.empty()) {
+				// Failover, detect the sensor again on the new path.
+				devicename.swap(rebound);
+				rebound.clear();
+				sensor.clear();
+				source = None;
+				next = 0;
+			}
+		}
+
+		if(timestamp < next) {
+			return;
+		}
+
+		next = timestamp + interval;
+
+		float celsius = 0;
+		bool valid = false;
+
+		try {
+
+			valid = read(celsius);
+
+		} catch(const std::exception &) {
+
+			// Throttled or failed, keep the last sample.
+			return;
+
+		}
+
+		lock_guard<mutex> lock(guard);
+
+		current = celsius;
+		available = valid;
+
+		if(valid) {
+			for(Window &window : windows) {
+				window.push_back(celsius,timestamp);
+			}
+		}
+
+	}
+
+	bool Smart::Thermal::get(Udjat::Temperature &temperature) const noexcept {
+
+		lock_guard<mutex> lock(guard);
+
+		if(!available) {
+			return false;
+		}
+
+		temperature.set(current, Temperature::Celsius);
+
+		try {
+			temperature.set(Smart::unity());
+		} catch(const std::exception &) {
+			// Invalid unit on configuration, keep Celsius.
+		}
+
+		return true;
+
+	}
+
+	bool Smart::Thermal::get(size_t window, time_t &seconds, Window::Value &value) const noexcept {
+
+		if(window >= MAX_WINDOWS || !windows[window].length()) {
+			return false;
+		}
+
+		lock_guard<mutex> lock(guard);
+
+		seconds = windows[window].length();
+		value = windows[window].get(time(nullptr));
+
+		return true;
+
+	}
+
+ }
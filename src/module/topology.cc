@@ -0,0 +1,404 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the storage topology (host adapter, enclosure, slot).
+  *
+  * The device path is the sysfs link target, for example:
+  *
+  * /sys/devices/pci0000:00/0000:00:03.0/0000:03:00.0/host0/port-0:0/expander-0:0/port-0:0:5/end_device-0:0:5/target0:0:5/0:0:5:0/block/sdf
+  *
+  * SES managed slots are linked as /sys/block/<name>/device/enclosure_device:<slot>.
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/tools/quark.h>
+ #include <udjat/tools/intl.h>
+ #include <dirent.h>
+ #include <climits>
+ #include <cstring>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Check for PCI addresses (0000:03:00.0).
+	static bool is_pci_address(const string &str) {
+		unsigned int domain, bus, device, function;
+		char extra;
+		return str.size() == 12 && sscanf(str.c_str(),"%4x:%2x:%2x.%1x%c",&domain,&bus,&device,&function,&extra) == 4;
+	}
+
+	/// @brief Get a name usable as agent name.
+	static const char * agent_name(const string &id) {
+		string name{id};
+		for(char &chr : name) {
+			if(!isalnum(chr)) {
+				chr = '-';
+			}
+		}
+		return Quark(name).c_str();
+	}
+
+	Smart::Location::Location(const std::string &name) {
+
+		char buffer[PATH_MAX+1];
+		if(!realpath((string{"/sys/block/"} + name).c_str(),buffer)) {
+			return;
+		}
+
+		string port, ata;
+
+		const char *ptr = buffer;
+		while(*ptr) {
+
+			while(*ptr == '/') {
+				ptr++;
+			}
+
+			size_t length = strcspn(ptr,"/");
+			string component{ptr,length};
+			ptr += length;
+
+			if(is_pci_address(component)) {
+				// The last PCI device on the path is the host adapter.
+				controller = component;
+				enclosure.clear();
+				port.clear();
+				ata.clear();
+			} else if(!strncmp(component.c_str(),"expander-",9)) {
+				enclosure = component;
+				port.clear();
+			} else if(!strncmp(component.c_str(),"port-",5)) {
+				port = component;
+			} else if(!strncmp(component.c_str(),"ata",3) && isdigit(component[3])) {
+				ata = component;
+			}
+
+		}
+
+		slot = (port.empty() ? ata : port);
+
+		// SES managed enclosure, get the slot name.
+		string path{string{"/sys/block/"} + name + "/device"};
+		DIR *dir = opendir(path.c_str());
+		if(!dir) {
+			return;
+		}
+
+		struct dirent *entry;
+		while((entry = readdir(dir)) != NULL) {
+
+			if(strncmp(entry->d_name,"enclosure_device:",17)) {
+				continue;
+			}
+
+			slot = entry->d_name + 17;
+
+			// The link target is .../<enclosure>/enclosure/<enclosure>/<slot>.
+			if(realpath((path + "/" + entry->d_name).c_str(),buffer)) {
+				char *end = strrchr(buffer,'/');
+				if(end) {
+					*end = 0;
+					end = strrchr(buffer,'/');
+					if(end) {
+						enclosure = end+1;
+					}
+				}
+			}
+
+			break;
+		}
+
+		closedir(dir);
+
+	}
+
+	Smart::Controller::Controller(const std::string &i, unsigned int t, time_t w) : threshold{t}, window{w}, id{i} {
+	}
+
+	bool Smart::Controller::suspended() noexcept {
+		lock_guard<mutex> lock(guard);
+		return until && time(nullptr) < until;
+	}
+
+	Smart::Controller::Verdict Smart::Controller::failed(const void *member) noexcept {
+
+		lock_guard<mutex> lock(guard);
+
+		time_t now = time(nullptr);
+
+		if(!backoff) {
+			// Not on a correlated failure, forget the old ones.
+			for(auto it = failures.begin(); it != failures.end();) {
+				if(now - it->second > window) {
+					it = failures.erase(it);
+				} else {
+					it++;
+				}
+			}
+		}
+
+		bool found = false;
+		for(auto &failure : failures) {
+			if(failure.first == member) {
+				failure.second = now;
+				found = true;
+				break;
+			}
+		}
+
+		if(!found) {
+			failures.emplace_back(member,now);
+		}
+
+		if(backoff && now < until) {
+			// Already backing off.
+			return Correlated;
+		}
+
+		size_t needed = std::max((size_t) 2, ((members * threshold) + 99) / 100);
+
+		if(members < 2 || failures.size() < needed) {
+			return (backoff ? Correlated : Isolated);
+		}
+
+		// Correlated failure, back off (doubling while it persists, up to one hour).
+		if(backoff) {
+			backoff = std::min(backoff * 2, (time_t) 3600);
+			until = now + backoff;
+			return Correlated;
+		}
+
+		backoff = 60;
+		until = now + backoff;
+		events++;
+
+		return Started;
+
+	}
+
+	void Smart::Controller::succeeded(const void *member) noexcept {
+
+		lock_guard<mutex> lock(guard);
+
+		for(auto it = failures.begin(); it != failures.end(); it++) {
+			if(it->first == member) {
+				failures.erase(it);
+				break;
+			}
+		}
+
+		if(backoff && failures.size() < std::max((size_t) 2, ((members * threshold) + 99) / 100)) {
+			// The controller is back.
+			backoff = 0;
+			until = 0;
+		}
+
+	}
+
+	Smart::Controller::Status Smart::Controller::get() noexcept {
+
+		lock_guard<mutex> lock(guard);
+
+		Status status;
+		status.members = members;
+		status.failing = failures.size();
+		status.events = events;
+		status.correlated = (backoff != 0);
+
+		time_t now = time(nullptr);
+		if(until > now) {
+			status.backoff = until - now;
+		}
+
+		return status;
+
+	}
+
+	Smart::Group::Group(const std::string &id, const std::string &label, const char *icon) : Udjat::Agent<unsigned short>(agent_name(id),Ready) {
+		Object::properties.icon = icon;
+		Object::properties.label = Quark(label).c_str();
+	}
+
+	void Smart::Group::add(std::shared_ptr<Smart::Agent> agent, const std::string &slot) {
+		lock_guard<mutex> lock(guard);
+		members.push_back(Member{agent,slot,make_shared<Load>(agent->getDeviceName())});
+	}
+
+	bool Smart::Group::refresh() {
+
+		lock_guard<mutex> lock(guard);
+
+		unsigned int counters[3] = { 0, 0, 0 };	// ready, warning, error.
+		Udjat::Level level = Udjat::undefined;
+		const char *summary = "";
+
+		for(auto &member : members) {
+
+			auto state = member.agent->state();
+			Udjat::Level current = (state ? state->level() : Udjat::undefined);
+
+			if(current >= Udjat::error) {
+				counters[2]++;
+			} else if(current == Udjat::warning) {
+				counters[1]++;
+			} else {
+				counters[0]++;
+			}
+
+			if(state && current > level) {
+				level = current;
+				summary = state->summary();
+			}
+
+		}
+
+		for(size_t ix = 0; ix < 3; ix++) {
+			count[ix] = counters[ix];
+		}
+		worst = summary;
+
+		unsigned short previous = super::get();
+		unsigned short value = Ready;
+
+		if(controller && controller->get().correlated) {
+			// One state for the host adapter, the member failures are folded into it.
+			value = Correlated;
+		} else if(counters[2]) {
+			value = Failed;
+		} else if(counters[1]) {
+			value = Warning;
+		}
+
+		set(value);
+
+		if(value != previous) {
+			Events::getInstance().push_back(name(),"state",computeState()->name());
+		}
+
+		return true;
+
+	}
+
+	void Smart::Group::get(const Udjat::Request &request, Udjat::Response &response) {
+
+		// From the cached member states, doesn't touch the disks.
+		refresh();
+
+		Udjat::Abstract::Agent::get(request,response);
+
+		lock_guard<mutex> lock(guard);
+
+		float latency = 0;
+		unsigned int samples = 0;
+
+		Udjat::Value &slots = response["slots"];
+
+		for(auto &member : members) {
+
+			auto state = member.agent->state();
+
+			Load::Value load = member.load->sample();
+			if(load.latency > 0) {
+				latency += load.latency;
+				samples++;
+			}
+
+			Udjat::Value &value = slots.append();
+			value["name"] = member.agent->name();
+			value["slot"] = member.slot;
+			value["state"] = (state ? state->summary() : "");
+			value["latency"] = load.latency;
+
+		}
+
+		response["disks"] = (unsigned int) members.size();
+		response["ready"] = count[0];
+		response["warning"] = count[1];
+		response["error"] = count[2];
+		response["worst"] = worst;
+		response["latency"] = (samples ? latency / samples : 0.0f);
+
+		if(controller) {
+			Controller::Status status = controller->get();
+			response["failing"] = (unsigned int) status.failing;
+			response["backoff"] = (unsigned int) status.backoff;
+			response["correlated-failures"] = (unsigned int) status.events;
+		}
+
+	}
+
+	std::shared_ptr<Abstract::State> Smart::Group::computeState() {
+
+		unsigned short value = super::get();
+
+		for(auto state : states) {
+			if(state->compare(value))
+				return state;
+		}
+
+		static const struct {
+			unsigned short					  value;
+			const char 						* name;
+			Udjat::Level					  level;
+			const char						* summary;
+		} predefined_states[] = {
+			{ Ready,		"ready",		Udjat::ready,	N_( "Disks are ready" )										},
+			{ Warning,		"warning",		Udjat::warning,	N_( "Disks report health warnings" )						},
+			{ Failed,		"failed",		Udjat::error,	N_( "Disks report errors" )									},
+			{ Correlated,	"correlated",	Udjat::error,	N_( "Correlated disk failures, host adapter backing off" )	},
+		};
+
+		for(size_t ix = 0; ix < N_ELEMENTS(predefined_states); ix++) {
+
+			if(predefined_states[ix].value == value) {
+
+#ifdef GETTEXT_PACKAGE
+				string summary{dgettext(GETTEXT_PACKAGE,predefined_states[ix].summary)};
+#else
+				string summary{predefined_states[ix].summary};
+#endif // GETTEXT_PACKAGE
+
+				summary += " (";
+				summary += Object::properties.label;
+				summary += ")";
+
+				auto new_state =
+					make_shared<Udjat::State<unsigned short>>(
+						predefined_states[ix].name,
+						predefined_states[ix].value,
+						predefined_states[ix].level,
+						Quark(summary).c_str(),
+						""
+					);
+
+				states.push_back(new_state);
+				return new_state;
+
+			}
+
+		}
+
+		return Abstract::Agent::computeState();
+
+	}
+
+ }
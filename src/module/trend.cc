@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ /**
+  * @brief Implements the failure trend estimator.
+  *
+  * <https://en.wikipedia.org/wiki/Recursive_least_squares_filter>
+  *
+  */
+
+ #include "private.h"
+ #include <udjat/smart/trend.h>
+ #include <cmath>
+ #include <limits>
+
+ namespace Udjat {
+
+	void Smart::Trend::push_back(double value, time_t timestamp) {
+
+		if(!samples) {
+			origin = timestamp;
+		}
+
+		double x = (double) (timestamp - origin);
+
+		sum.w	= (sum.w * lambda) + 1;
+		sum.x	= (sum.x * lambda) + x;
+		sum.y	= (sum.y * lambda) + value;
+		sum.xx	= (sum.xx * lambda) + (x * x);
+		sum.xy	= (sum.xy * lambda) + (x * value);
+
+		last = value;
+		samples++;
+
+	}
+
+	double Smart::Trend::slope() const noexcept {
+
+		if(samples < 2) {
+			return 0;
+		}
+
+		double denominator = (sum.w * sum.xx) - (sum.x * sum.x);
+		if(fabs(denominator) < 1e-9) {
+			return 0;
+		}
+
+		return ((sum.w * sum.xy) - (sum.x * sum.y)) / denominator;
+
+	}
+
+	uint64_t Smart::Trend::predict(double limit, time_t timestamp) const noexcept {
+
+		if(!samples) {
+			return 0;
+		}
+
+		// Already past the limit?
+		if(rising ? (last >= limit) : (last <= limit)) {
+			return 1;
+		}
+
+		double m = slope();
+
+		// Stable or moving away from the limit?
+		if(!std::isfinite(m) || (rising ? (m <= 0) : (m >= 0))) {
+			return 0;
+		}
+
+		double intercept = (sum.y - (m * sum.x)) / sum.w;
+		double when = ((limit - intercept) / m) - (double) (timestamp - origin);
+
+		if(!std::isfinite(when) || when >= (double) std::numeric_limits<uint64_t>::max()) {
+			return std::numeric_limits<uint64_t>::max();
+		}
+
+		if(when < 1) {
+			return 1;
+		}
+
+		return (uint64_t) when;
+
+	}
+
+ }